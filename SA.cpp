@@ -4,7 +4,38 @@
 #include <algorithm>
 #include <chrono>
 #include <fstream>
+#include <sstream>
 #include <numeric>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <atomic>
+#include <string_view>
+#include <functional>
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <climits>
+#include <cerrno>
+#include <csignal>
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/syscall.h>
+#include <sys/ioctl.h>
+#include <linux/perf_event.h>
+#include <linux/mempolicy.h>
+#include <sched.h>
+#include <poll.h>
+#include <unistd.h>
 
 using namespace std;
 using namespace chrono;
@@ -18,6 +49,174 @@ const int SEED_LEN = 10;
 // spaced seed 패턴: 1이면 해당 위치를 비교, 0이면 무시
 const int SPACED_SEED_PATTERN[] = {1, 1, 0, 1, 1, 0, 1};
 
+// mmap 영역 또는 vector를 가리키는 읽기 전용 int 배열 뷰
+struct IntView {
+    const int* ptr = nullptr;
+    size_t len = 0;
+
+    IntView() = default;
+    IntView(const vector<int>& v) : ptr(v.data()), len(v.size()) {}
+    IntView(const int* p, size_t n) : ptr(p), len(n) {}
+
+    int operator[](size_t i) const { return ptr[i]; }
+    size_t size() const { return len; }
+};
+
+// reference 위치·SA 순위 타입
+// 기본 빌드는 int (reference 2^31 bp 미만, 작은 게놈에서 가장 빠름)
+// -DALIGNER_POS40으로 컴파일하면 int64로 다루고, SA처럼 위치를 담는 큰 배열은 항목당 5바이트(40비트, 최대 2^40 bp)로 저장
+#ifdef ALIGNER_POS40
+using Pos = int64_t;
+const int POS_BYTES = 5;
+#else
+using Pos = int;
+const int POS_BYTES = 4;
+#endif
+
+// 이 빌드가 받는 reference 최대 길이 (SA 구축은 끝 널 문자까지 길이 + 1개의 위치를 다룸)
+const uint64_t MAX_REF_LEN = POS_BYTES == 5 ? (1ULL << 40) - 2 : (uint64_t)INT_MAX - 1;
+
+// 위치 배열의 바이트 수 (40비트 빌드는 마지막 항목도 8바이트 읽기로 꺼낼 수 있도록 3바이트 여유)
+inline size_t posArrayBytes(size_t n) { return n * POS_BYTES + (POS_BYTES == 5 && n > 0 ? 3 : 0); }
+
+// 위치 배열 뷰 (SA, k-mer 테이블, spaced seed 인덱스, FM SA 샘플): 항목당 POS_BYTES바이트
+// 40비트 항목은 바이트 경계에 붙여 저장하고 8바이트 읽기 + 마스크로 꺼냄 (항목 하나가 캐시 라인 하나에 거의 항상 들어감)
+struct PosView {
+    const char* ptr = nullptr;
+    size_t len = 0;
+
+    PosView() = default;
+    PosView(const void* p, size_t n) : ptr((const char*)p), len(n) {}
+
+    Pos operator[](size_t i) const {
+#ifdef ALIGNER_POS40
+        uint64_t v;
+        memcpy(&v, ptr + 5 * i, 8);
+        return v & 0xFFFFFFFFFFULL;
+#else
+        int v;
+        memcpy(&v, ptr + 4 * i, 4);
+        return v;
+#endif
+    }
+    const char* addr(size_t i) const { return ptr + POS_BYTES * i; }
+    size_t size() const { return len; }
+};
+
+// 위치 배열 저장소: 32비트 빌드는 구축 결과 vector<int>를 그대로, 40비트 빌드는 5바이트씩 채운 바이트 배열
+#ifdef ALIGNER_POS40
+using PosStorage = vector<char>;
+
+PosStorage packPositions(vector<Pos>&& v) {
+    PosStorage out(posArrayBytes(v.size()));
+    for (size_t i = 0; i < v.size(); ++i) memcpy(out.data() + 5 * i, &v[i], 5);  // 리틀 엔디언 하위 5바이트
+    vector<Pos>().swap(v);
+    return out;
+}
+
+PosView viewPositions(const PosStorage& s) { return PosView(s.data(), s.empty() ? 0 : (s.size() - 3) / 5); }
+#else
+using PosStorage = vector<int>;
+
+PosStorage packPositions(vector<Pos>&& v) { return move(v); }
+PosView viewPositions(const PosStorage& s) { return PosView(s.data(), s.size()); }
+#endif
+
+// 구축 중 쓰는 위치 작업 배열 (항목당 POS_BYTES바이트, 40비트 빌드에서 int64 배열의 5/8)
+// 스레드들이 서로 다른 항목을 동시에 읽고 쓸 수 있도록 PosView와 달리 항목 바이트만 정확히 접근
+class PosArray {
+    vector<char> bytes;
+
+public:
+    explicit PosArray(size_t n) : bytes(n * POS_BYTES) {}
+    Pos get(size_t i) const {
+        Pos v = 0;
+        memcpy(&v, bytes.data() + POS_BYTES * i, POS_BYTES);
+        return v;
+    }
+    void set(size_t i, Pos v) { memcpy(bytes.data() + POS_BYTES * i, &v, POS_BYTES); }
+    char* slot(size_t i) { return bytes.data() + POS_BYTES * i; }
+};
+
+// 염기 → 2비트 코드 (A=0, C=1, G=2, T=3, 그 외 -1)
+inline int baseCode(char c) {
+    switch (c) {
+        case 'A': return 0;
+        case 'C': return 1;
+        case 'G': return 2;
+        case 'T': return 3;
+        default: return -1;
+    }
+}
+
+// 2비트 압축 염기 서열 뷰 (A=0, C=1, G=2, T=3), 64비트 워드 하나에 32염기를 상위 비트부터 저장
+// 상위 비트부터 채우므로 워드 정수 비교가 곧 사전순 비교이며, 끝에 0 워드 하나를 덧붙여 어느 위치에서든 32염기 창을 꺼낼 수 있음
+struct PackedRef {
+    const uint64_t* words = nullptr;
+    size_t len = 0;
+
+    PackedRef() = default;
+    PackedRef(const uint64_t* w, size_t n) : words(w), len(n) {}
+
+    size_t size() const { return len; }
+    int code(size_t i) const { return (words[i >> 5] >> (62 - 2 * (i & 31))) & 3; }
+    char operator[](size_t i) const { return "ACGT"[code(i)]; }
+
+    // pos부터 32염기 (pos & 31 == 0이면 두 번째 워드는 시프트로 모두 밀려남)
+    uint64_t window(size_t pos) const {
+        size_t w = pos >> 5, off = 2 * (pos & 31);
+        return (words[w] << off) | ((words[w + 1] >> 1) >> (63 - off));
+    }
+
+    // string_view::compare와 같은 의미: [pos, pos + count) 구간과 pattern의 사전순 비교
+    int compare(size_t pos, size_t count, string_view pattern) const {
+        size_t rlen = min(count, len - pos), k = min(rlen, pattern.size());
+        for (size_t i = 0; i < k; ++i) {
+            char c = (*this)[pos + i];
+            if (c != pattern[i]) return c < pattern[i] ? -1 : 1;
+        }
+        return rlen < pattern.size() ? -1 : (rlen > pattern.size() ? 1 : 0);
+    }
+};
+
+// ACGT 문자열을 2비트로 압축 (PackedRef 형식, 끝에 0 워드 하나 추가)
+vector<uint64_t> packSequence(string_view s) {
+    vector<uint64_t> words((s.size() + 31) / 32 + 1, 0);
+    for (size_t i = 0; i < s.size(); ++i)
+        words[i >> 5] |= (uint64_t)max(baseCode(s[i]), 0) << (62 - 2 * (i & 31));
+    return words;
+}
+
+// 2비트 압축 read: 워드마다 유효 위치 마스크(valid)와 ACGT 외 문자 위치 마스크(nmask)를 함께 둠
+// 마스크는 염기마다 하위 비트(01)만 사용하며, nmask 위치는 reference와 항상 mismatch로 셈
+struct PackedRead {
+    vector<uint64_t> words, valid, nmask;
+    int len = 0;
+
+    // 버퍼를 재사용하므로 같은 길이 이하의 read는 할당 없이 압축됨
+    void assign(string_view read) {
+        len = read.size();
+        size_t nw = (read.size() + 31) / 32;
+        words.assign(nw, 0);
+        valid.assign(nw, 0x5555555555555555ULL);
+        nmask.assign(nw, 0);
+        for (size_t i = 0; i < read.size(); ++i) {
+            int c = baseCode(read[i]);
+            int shift = 62 - 2 * (i & 31);
+            if (c < 0) nmask[i >> 5] |= 1ULL << shift;
+            else words[i >> 5] |= (uint64_t)c << shift;
+        }
+        if (read.size() & 31) valid[nw - 1] &= ~0ULL << (64 - 2 * (read.size() & 31));
+    }
+
+    // words 또는 nmask에서 pos부터 32염기 창 (read 끝 이후는 0)
+    static uint64_t window(const vector<uint64_t>& v, size_t pos) {
+        size_t w = pos >> 5, off = 2 * (pos & 31);
+        uint64_t next = w + 1 < v.size() ? v[w + 1] : 0;
+        return (v[w] << off) | ((next >> 1) >> (63 - off));
+    }
+};
+
 // 시간 측정용 유틸 함수
 void printTime(const string& label, high_resolution_clock::time_point start, high_resolution_clock::time_point end) {
     double duration = chrono::duration_cast<chrono::duration<double>>(end - start).count();
@@ -25,13 +224,13 @@ void printTime(const string& label, high_resolution_clock::time_point start, hig
 }
 
 // 접미사 배열(Suffix Array) 구축 함수 (Doubling 방식)
-vector<int> buildSuffixArray(const string& s_input) {
+vector<Pos> buildSuffixArrayDoubling(const string& s_input) {
     string s = s_input + '\0'; // 문자열 마지막에 널 문자 추가
-    int n = s.size();
+    Pos n = s.size();
 
     // 문자 → 숫자 치환
-    vector<int> s_int(n);
-    for (int i = 0; i < n; ++i) {
+    vector<Pos> s_int(n);
+    for (Pos i = 0; i < n; ++i) {
         if (s[i] == 'A') s_int[i] = 1;
         else if (s[i] == 'C') s_int[i] = 2;
         else if (s[i] == 'G') s_int[i] = 3;
@@ -39,22 +238,22 @@ vector<int> buildSuffixArray(const string& s_input) {
         else s_int[i] = 0;
     }
 
-    vector<int> sa(n), rank = s_int, tmp(n);
+    vector<Pos> sa(n), rank = s_int, tmp(n);
     iota(sa.begin(), sa.end(), 0); // sa 초기화 (0 ~ n-1)
 
-    for (int k = 1;; k <<= 1) {
+    for (Pos k = 1;; k <<= 1) {
         // rank 기준 정렬 비교 함수 정의
-        auto cmp = [&](int i, int j) {
+        auto cmp = [&](Pos i, Pos j) {
             if (rank[i] != rank[j]) return rank[i] < rank[j];
-            int ri = (i + k < n) ? rank[i + k] : -1;
-            int rj = (j + k < n) ? rank[j + k] : -1;
+            Pos ri = (i + k < n) ? rank[i + k] : -1;
+            Pos rj = (j + k < n) ? rank[j + k] : -1;
             return ri < rj;
         };
         sort(sa.begin(), sa.end(), cmp); // 접미사 정렬 수행
 
         // 새 랭크 할당
         tmp[sa[0]] = 0;
-        for (int i = 1; i < n; ++i)
+        for (Pos i = 1; i < n; ++i)
             tmp[sa[i]] = tmp[sa[i - 1]] + (cmp(sa[i - 1], sa[i]) ? 1 : 0);
         rank = tmp;
         if (rank[sa[n - 1]] == n - 1) break; // 모든 순위가 고유하면 종료
@@ -64,157 +263,4329 @@ vector<int> buildSuffixArray(const string& s_input) {
     return sa;
 }
 
+// SA-IS 보조: 문자별 버킷의 시작(end=false) 또는 끝(end=true) 위치 계산
+template <class Char>
+void getBuckets(const Char* s, Pos n, Pos K, Pos* bkt, bool end) {
+    fill(bkt, bkt + K, 0);
+    for (Pos i = 0; i < n; ++i) bkt[s[i]]++;
+    Pos sum = 0;
+    for (Pos c = 0; c < K; ++c) {
+        sum += bkt[c];
+        bkt[c] = end ? sum : sum - bkt[c];
+    }
+}
+
+// SA-IS 보조: LMS 위치로부터 L형, S형 접미사를 차례로 유도 정렬
+template <class Char>
+void induceSA(const Char* s, const vector<bool>& t, Pos* sa, Pos n, Pos K, Pos* bkt) {
+    getBuckets(s, n, K, bkt, false);
+    for (Pos i = 0; i < n; ++i) {
+        Pos j = sa[i] - 1;
+        if (sa[i] > 0 && !t[j]) sa[bkt[s[j]]++] = j;
+    }
+    getBuckets(s, n, K, bkt, true);
+    for (Pos i = n - 1; i >= 0; --i) {
+        Pos j = sa[i] - 1;
+        if (sa[i] > 0 && t[j]) sa[--bkt[s[j]]] = j;
+    }
+}
+
+// SA-IS 본체 (Nong-Zhang-Chan): s[n-1]은 유일한 최소 문자(0)여야 함
+// 축약 문자열 s1과 그 SA를 sa 배열 안에 그대로 두어 추가 메모리는 타입 비트 n개 + 버킷 K개뿐
+// 최상위 문자열은 염기 코드(uint8_t), 재귀의 축약 문자열만 이름이 위치 범위라 Pos
+template <class Char>
+void sais(const Char* s, Pos* sa, Pos n, Pos K) {
+    vector<bool> t(n);
+    vector<Pos> bkt(K);
+    t[n - 1] = true; // S형
+    for (Pos i = n - 2; i >= 0; --i)
+        t[i] = s[i] < s[i + 1] || (s[i] == s[i + 1] && t[i + 1]);
+    auto isLMS = [&](Pos i) { return i > 0 && t[i] && !t[i - 1]; };
+
+    // 1단계: LMS 부분 문자열 정렬
+    getBuckets(s, n, K, bkt.data(), true);
+    fill(sa, sa + n, -1);
+    for (Pos i = 1; i < n; ++i)
+        if (isLMS(i)) sa[--bkt[s[i]]] = i;
+    induceSA(s, t, sa, n, K, bkt.data());
+
+    Pos n1 = 0;
+    for (Pos i = 0; i < n; ++i)
+        if (isLMS(sa[i])) sa[n1++] = sa[i];
+
+    // LMS 부분 문자열에 이름 부여 (같은 부분 문자열은 같은 이름)
+    fill(sa + n1, sa + n, -1);
+    Pos name = 0, prev = -1;
+    for (Pos i = 0; i < n1; ++i) {
+        Pos pos = sa[i];
+        bool diff = false;
+        for (Pos d = 0; d < n; ++d) {
+            if (prev == -1 || s[pos + d] != s[prev + d] || t[pos + d] != t[prev + d]) {
+                diff = true;
+                break;
+            }
+            if (d > 0 && (isLMS(pos + d) || isLMS(prev + d))) break;
+        }
+        if (diff) {
+            ++name;
+            prev = pos;
+        }
+        sa[n1 + pos / 2] = name - 1;
+    }
+    for (Pos i = n - 1, j = n - 1; i >= n1; --i)
+        if (sa[i] >= 0) sa[j--] = sa[i];
+
+    // 2단계: 축약 문자열 s1의 SA 계산 (이름이 모두 다르면 바로 계산)
+    Pos* sa1 = sa;
+    Pos* s1 = sa + n - n1;
+    if (name < n1)
+        sais<Pos>(s1, sa1, n1, name);
+    else
+        for (Pos i = 0; i < n1; ++i) sa1[s1[i]] = i;
+
+    // 3단계: 정렬된 LMS 접미사로부터 전체 SA 유도
+    getBuckets(s, n, K, bkt.data(), true);
+    for (Pos i = 1, j = 0; i < n; ++i)
+        if (isLMS(i)) s1[j++] = i;
+    for (Pos i = 0; i < n1; ++i) sa1[i] = s1[sa1[i]];
+    fill(sa + n1, sa + n, -1);
+    for (Pos i = n1 - 1; i >= 0; --i) {
+        Pos j = sa[i];
+        sa[i] = -1;
+        sa[--bkt[s[j]]] = j;
+    }
+    induceSA(s, t, sa, n, K, bkt.data());
+}
+
+// 접미사 배열 구축 함수 (SA-IS, 선형 시간)
+// doubling 방식과 같은 문자 → 숫자 치환(널=0, A~T=1~4)을 쓰므로 결과가 동일함
+// 구축 중 메모리는 염기 코드 1 바이트/bp + SA 작업 배열 (40비트 빌드는 8 바이트/bp)
+vector<Pos> buildSuffixArraySAIS(const string& s_input) {
+    Pos n = s_input.size() + 1;
+    vector<uint8_t> s_int(n, 0);
+    vector<Pos> sa(n);
+    for (Pos i = 0; i < n - 1; ++i) {
+        char c = s_input[i];
+        if (c == 'A') s_int[i] = 1;
+        else if (c == 'C') s_int[i] = 2;
+        else if (c == 'G') s_int[i] = 3;
+        else if (c == 'T') s_int[i] = 4;
+        else return buildSuffixArrayDoubling(s_input); // 끝 널 문자가 유일한 최소값이어야 하므로 ACGT 외 문자는 doubling으로 처리
+    }
+
+    sais(s_int.data(), sa.data(), n, 5);
+    sa.erase(sa.begin()); // 마지막 null 제거
+    return sa;
+}
+
+// 두 접미사의 첫 depth염기 사전순 비교 (2비트 압축본에서 32염기씩, 한쪽이 다른 쪽의 접두사면 짧은 쪽이 앞)
+// 음수/양수: a가 앞/뒤, 0: 둘 다 depth염기 이상이고 첫 depth염기가 같음
+inline int compareSuffix(const PackedRef& ref, Pos a, Pos b, size_t depth) {
+    size_t la = ref.size() - a, lb = ref.size() - b, common = min(min(la, lb), depth);
+    for (size_t off = 0; off < common; off += 32) {
+        uint64_t wa = ref.window(a + off), wb = ref.window(b + off);
+        if (common - off < 32) {
+            uint64_t mask = ~0ULL << (64 - 2 * (common - off));
+            wa &= mask;
+            wb &= mask;
+        }
+        if (wa != wb) return wa < wb ? -1 : 1;
+    }
+    if (common == depth) return 0;
+    return la < lb ? -1 : 1;
+}
+
+// 버킷 안 비교 정렬의 깊이 (염기): 반복 구간이 길어도 비교 한 번이 4워드를 넘지 않음
+const size_t PARALLEL_SORT_DEPTH = 128;
+
+// 첫 h염기가 같은 접미사 그룹 [first, last)들을 Larsson-Sadakane 방식 prefix doubling으로 마저 정렬
+// rank[i]: 접미사 i가 속한 그룹의 SA 시작 위치 (첫 h염기 순서와 같음)
+// 매 단계 그룹마다 (rank[i + h], i)로 독립 정렬한 뒤 (병렬) 갈라진 하위 그룹의 rank를 갱신하고 h를 두 배로 늘림
+// → 반복 길이 L에 대해 log(L / h)단계, 단계마다 아직 안 갈라진 접미사만 정렬
+void refineSuffixGroups(vector<Pos>& sa, PosArray& rank, vector<pair<Pos, Pos>> groups, size_t h, int T) {
+    Pos n = sa.size();
+    while (!groups.empty()) {
+        vector<vector<Pos>> heads(groups.size());  // 그룹마다 정렬 후 하위 그룹 시작 위치
+        #pragma omp parallel for schedule(dynamic, 1) num_threads(T)
+        for (size_t g = 0; g < groups.size(); ++g) {
+            auto [first, last] = groups[g];
+            vector<pair<Pos, Pos>> keyed(last - first);
+            for (Pos j = first; j < last; ++j) {
+                Pos i = sa[j];
+                keyed[j - first] = {i + (Pos)h < n ? rank.get(i + h) : -1, i};
+            }
+            sort(keyed.begin(), keyed.end());
+            for (Pos j = first; j < last; ++j) {
+                sa[j] = keyed[j - first].second;
+                if (j == first || keyed[j - first].first != keyed[j - first - 1].first) heads[g].push_back(j);
+            }
+        }
+        // 모든 그룹의 정렬 키를 읽은 뒤에 rank를 바꿔야 하므로 갱신은 따로 (그룹마다 자기 원소만 씀)
+        #pragma omp parallel for schedule(dynamic, 1) num_threads(T)
+        for (size_t g = 0; g < groups.size(); ++g) {
+            const vector<Pos>& hd = heads[g];
+            for (size_t k = 0; k < hd.size(); ++k) {
+                Pos end = k + 1 < hd.size() ? hd[k + 1] : groups[g].second;
+                for (Pos j = hd[k]; j < end; ++j) rank.set(sa[j], hd[k]);
+            }
+        }
+        vector<pair<Pos, Pos>> next;
+        for (size_t g = 0; g < groups.size(); ++g)
+            for (size_t k = 0; k < heads[g].size(); ++k) {
+                Pos end = k + 1 < heads[g].size() ? heads[g][k + 1] : groups[g].second;
+                if (end - heads[g][k] > 1) next.push_back({heads[g][k], end});
+            }
+        groups.swap(next);
+        h *= 2;
+    }
+}
+
+// 병렬 SA 구축: 첫 k염기 2비트 코드로 접미사를 4^k개 버킷에 나눈 뒤 (스레드별 히스토그램 → 누적합 → 분배)
+// 버킷마다 독립적으로 첫 PARALLEL_SORT_DEPTH염기까지 비교 정렬 (버킷 크기가 제각각이므로 dynamic 스케줄)
+// 그 깊이까지 같은 그룹이 남으면 (긴 반복 구간) refineSuffixGroups로 마저 정렬 → 반복이 길어도 비교 비용이 커지지 않음
+// 끝에서 k염기가 안 되는 접미사는 A로 채운 코드의 버킷에 들어가며, 짧은 쪽이 앞이라는 비교 규칙으로 버킷 맨 앞에 놓임
+// ACGT 외 문자가 있으면 SA-IS로 구축
+vector<Pos> buildSuffixArrayParallel(const string& s, int threads) {
+    Pos n = s.size();
+    for (char c : s)
+        if (baseCode(c) < 0) return buildSuffixArraySAIS(s);
+    vector<uint64_t> words = packSequence(s);
+    PackedRef ref(words.data(), n);
+
+    int k = 1;
+    while (k < 9 && ((uint64_t)1 << (2 * (k + 1))) * 16 <= (uint64_t)n) ++k;
+    size_t buckets = (size_t)1 << (2 * k);
+    int T = max(1, threads);
+    auto chunk = [&](int t) { return (Pos)((int64_t)n * t / T); };
+    auto code = [&](Pos i) { return ref.window(i) >> (64 - 2 * k); };
+
+    vector<Pos> count((size_t)T * buckets, 0);
+    #pragma omp parallel for num_threads(T)
+    for (int t = 0; t < T; ++t) {
+        Pos* c = count.data() + (size_t)t * buckets;
+        for (Pos i = chunk(t); i < chunk(t + 1); ++i) c[code(i)]++;
+    }
+    vector<Pos> start(buckets + 1);
+    Pos sum = 0;
+    for (size_t b = 0; b < buckets; ++b) {
+        start[b] = sum;
+        for (int t = 0; t < T; ++t) {
+            Pos c = count[(size_t)t * buckets + b];
+            count[(size_t)t * buckets + b] = sum;
+            sum += c;
+        }
+    }
+    start[buckets] = n;
+
+    vector<Pos> sa(n);
+    #pragma omp parallel for num_threads(T)
+    for (int t = 0; t < T; ++t) {
+        Pos* next = count.data() + (size_t)t * buckets;
+        for (Pos i = chunk(t); i < chunk(t + 1); ++i) sa[next[code(i)]++] = i;
+    }
+    vector<Pos>().swap(count);
+
+    vector<pair<Pos, Pos>> groups;  // 첫 PARALLEL_SORT_DEPTH염기가 같은 구간
+    #pragma omp parallel for schedule(dynamic, 16) num_threads(T)
+    for (size_t b = 0; b < buckets; ++b) {
+        Pos first = start[b], last = start[b + 1];
+        sort(sa.begin() + first, sa.begin() + last,
+             [&](Pos a, Pos c) { return compareSuffix(ref, a, c, PARALLEL_SORT_DEPTH) < 0; });
+        vector<pair<Pos, Pos>> tied;
+        for (Pos j = first + 1, g = first; j <= last; ++j) {
+            if (j < last && compareSuffix(ref, sa[j - 1], sa[j], PARALLEL_SORT_DEPTH) == 0) continue;
+            if (j - g > 1) tied.push_back({g, j});
+            g = j;
+        }
+        if (!tied.empty()) {
+            #pragma omp critical
+            groups.insert(groups.end(), tied.begin(), tied.end());
+        }
+    }
+    if (groups.empty()) return sa;
+
+    // 반복 구간이 있을 때만 rank 배열을 둠 (구축 중 POS_BYTES 바이트/bp가 더 듦)
+    PosArray rank(n);
+    #pragma omp parallel for num_threads(T)
+    for (Pos j = 0; j < n; ++j) rank.set(sa[j], j);
+    #pragma omp parallel for schedule(dynamic, 16) num_threads(T)
+    for (size_t g = 0; g < groups.size(); ++g)
+        for (Pos j = groups[g].first; j < groups[g].second; ++j) rank.set(sa[j], groups[g].first);
+    refineSuffixGroups(sa, rank, move(groups), PARALLEL_SORT_DEPTH, T);
+    return sa;
+}
+
+// SA 구축 방식 선택
+enum class SABuilder { Doubling, SAIS, Parallel };
+
+vector<Pos> buildSuffixArray(const string& s, SABuilder builder, int threads = 1) {
+    if (builder == SABuilder::Doubling) return buildSuffixArrayDoubling(s);
+    if (builder == SABuilder::Parallel) return buildSuffixArrayParallel(s, threads);
+    return buildSuffixArraySAIS(s);
+}
+
 // LCP(Longest Common Prefix) 배열 구축 함수 (Kasai 알고리즘)
-vector<int> buildLCPArray(const string& s, const vector<int>& sa) {
-    int n = s.size();
-    vector<int> rank(n), lcp(n - 1);
-    for (int i = 0; i < n; ++i) rank[sa[i]] = i;
-
-    int h = 0;
-    for (int i = 0; i < n; ++i) {
-        if (rank[i] == 0) continue;
-        int j = sa[rank[i] - 1];
+// s는 reference 그대로 (끝 널 문자는 복사하지 않고 길이로 대신함), sa는 POS_BYTES바이트로 저장한 SA
+// LCP 값은 read 길이와만 비교하므로 int 범위를 넘으면 INT_MAX로 자름
+vector<int> buildLCPArray(const string& s, PosView sa) {
+    Pos n = s.size();
+    PosArray rank(n);
+    vector<int> lcp(n, 0);
+    for (Pos r = 0; r < n; ++r) rank.set(sa[r], r);
+
+    Pos h = 0;
+    for (Pos i = 0; i < n; ++i) {
+        Pos r = rank.get(i);
+        if (r == 0) {
+            h = 0;
+            continue;
+        }
+        Pos j = sa[r - 1];
         while (i + h < n && j + h < n && s[i + h] == s[j + h]) ++h;
-        lcp[rank[i] - 1] = h;
+        lcp[r - 1] = min<Pos>(h, INT_MAX);
         if (h > 0) --h;
     }
     return lcp;
 }
 
-// spaced seed 매칭 (패턴 위치 기반 간략 비교)
-bool spacedSeedMatch(const string& ref, const string& read, int pos) {
-    int match = 0, total = 0;
-    for (int i = 0; i < min(read.size(), sizeof(SPACED_SEED_PATTERN)/sizeof(int)); i++) {
-        if (SPACED_SEED_PATTERN[i]) {
-            if (ref[pos + i] == read[i]) match++;
-            total++;
+// 병렬 LCP 구축 (Φ 배열 방식): Φ[sa[r + 1]] = sa[r]로 텍스트 순서의 이전 접미사를 두고
+// PLCP[i] = LCP(i, Φ[i])를 텍스트 구간별로 나눠 계산 (PLCP[i + 1] >= PLCP[i] - 1 성질은 구간 안에서만 이용)
+// 결과는 buildLCPArray와 같음 (PLCP는 int로 Φ[i] 항목 자리에 덮어써 작업 배열은 Φ 하나뿐)
+vector<int> buildLCPArrayParallel(const string& s, PosView sa, int threads) {
+    Pos n = s.size();
+    int T = max(1, threads);
+    PosArray phi(n);
+    vector<int> lcp(n, 0);
+    #pragma omp parallel for num_threads(T)
+    for (Pos r = 1; r < n; ++r) phi.set(sa[r], sa[r - 1]);
+    Pos first = n > 0 ? sa[0] : 0;  // Φ가 없는 접미사 (사전순으로 가장 앞)
+
+    #pragma omp parallel for num_threads(T)
+    for (int t = 0; t < T; ++t) {
+        Pos h = 0;
+        for (Pos i = (int64_t)n * t / T; i < (int64_t)n * (t + 1) / T; ++i) {
+            int plcp = 0;
+            if (i == first) {
+                h = 0;
+            } else {
+                Pos j = phi.get(i);
+                while (i + h < n && j + h < n && s[i + h] == s[j + h]) ++h;
+                plcp = min<Pos>(h, INT_MAX);
+                if (h > 0) --h;
+            }
+            memcpy(phi.slot(i), &plcp, sizeof(plcp));
         }
     }
+
+    #pragma omp parallel for num_threads(T)
+    for (Pos r = 1; r < n; ++r) memcpy(&lcp[r - 1], phi.slot(sa[r]), sizeof(int));
+    return lcp;
+}
+
+// spaced seed 패턴의 비교 위치 마스크 (PackedRead 마스크와 같은 염기당 01 형식)
+constexpr uint64_t spacedSeedMask() {
+    uint64_t mask = 0;
+    for (size_t i = 0; i < sizeof(SPACED_SEED_PATTERN) / sizeof(int); ++i)
+        if (SPACED_SEED_PATTERN[i]) mask |= 1ULL << (62 - 2 * i);
+    return mask;
+}
+
+// 염기 단위 XOR 결과를 염기당 1비트(01)로 접음
+inline uint64_t foldBases(uint64_t x) { return (x | (x >> 1)) & 0x5555555555555555ULL; }
+
+// spaced seed 매칭 (패턴 위치만 XOR + popcount로 한 번에 비교)
+bool spacedSeedMatch(const PackedRef& ref, const PackedRead& read, Pos pos) {
+    uint64_t mask = spacedSeedMask() & read.valid[0];
+    uint64_t diff = (foldBases(ref.window(pos) ^ read.words[0]) | read.nmask[0]) & mask;
+    int total = __builtin_popcountll(mask);
+    int match = total - __builtin_popcountll(diff);
     return match >= total - (MAX_ERROR / 2); // 일정 비율 이상 일치 시 통과
 }
 
-// mismatch 수 계산
-int countMismatch(const string& a, const string& b) {
-    int count = 0;
-    for (int i = 0; i < a.size(); ++i)
-        if (a[i] != b[i]) count++;
+// 인덱스 키로 쓰는 spaced seed 패턴 (spaced seed 실험 결과에서 비교한 4가지, 1: 비교 / 0: 무시)
+// 7염기 패턴을 SPACED_SEED_REPEAT번 이어 붙인 span 21 마스크를 키로 삼아야 후보가 충분히 걸러짐
+constexpr int SPACED_SEED_COUNT = 4;
+constexpr const char* SPACED_SEED_PATTERNS[SPACED_SEED_COUNT] = {"1001111", "1010101", "1101101", "1110101"};
+constexpr int SPACED_SEED_PERIOD = 7, SPACED_SEED_REPEAT = 3;
+
+// 패턴 → 키 마스크 (비교 위치마다 염기 2비트 모두 1, 상위 비트부터)
+constexpr uint64_t spacedKeyMask(const char* pattern) {
+    uint64_t mask = 0;
+    for (int r = 0; r < SPACED_SEED_REPEAT; ++r)
+        for (int i = 0; i < SPACED_SEED_PERIOD; ++i)
+            if (pattern[i] == '1') mask |= 3ULL << (62 - 2 * (r * SPACED_SEED_PERIOD + i));
+    return mask;
+}
+
+// 패턴 P 전용 spaced seed 인덱스: 마스크가 컴파일 시점 상수이므로 패턴마다 따로 특수화됨
+// 인덱스는 reference 위치들을 (마스크 키, 위치) 순으로 정렬한 배열 (위치당 POS_BYTES 바이트)
+template <int P>
+struct SpacedSeed {
+    static constexpr int id = P;
+    static constexpr uint64_t mask = spacedKeyMask(SPACED_SEED_PATTERNS[P]);
+    static constexpr int span = SPACED_SEED_PERIOD * SPACED_SEED_REPEAT;
+
+    static uint64_t key(const PackedRef& ref, size_t pos) { return ref.window(pos) & mask; }
+
+    // 두 창이 패턴 위치에서 모두 일치하는지 (분기 없는 마스크 비교)
+    static bool same(uint64_t a, uint64_t b) { return ((a ^ b) & mask) == 0; }
+
+    static vector<Pos> build(const PackedRef& ref) {
+        Pos n = ref.size();
+        vector<pair<uint64_t, Pos>> keyed;
+        keyed.reserve(max<Pos>(0, n - span + 1));
+        for (Pos p = 0; p + span <= n; ++p) keyed.emplace_back(key(ref, p), p);
+        sort(keyed.begin(), keyed.end());
+        vector<Pos> index(keyed.size());
+        for (size_t i = 0; i < keyed.size(); ++i) index[i] = keyed[i].second;
+        return index;
+    }
+
+    // read 창 w와 패턴 위치가 일치하는 reference 위치들의 인덱스 구간 [lo, hi)
+    static pair<Pos, Pos> lookup(const PackedRef& ref, PosView index, uint64_t w) {
+        uint64_t k = w & mask;
+        Pos lo = 0, hi = index.size();
+        while (lo < hi) {
+            Pos mid = (lo + hi) / 2;
+            if (key(ref, index[mid]) < k) lo = mid + 1;
+            else hi = mid;
+        }
+        Pos left = lo;
+        hi = index.size();
+        while (lo < hi) {
+            Pos mid = (lo + hi) / 2;
+            if (same(ref.window(index[mid]), k)) lo = mid + 1;
+            else hi = mid;
+        }
+        return {left, lo};
+    }
+};
+
+// 컴파일 시점의 모든 패턴에 대해 f(SpacedSeed<P>{}) 호출 (활성 여부는 f에서 확인)
+template <int P = 0, class F>
+void forEachSpacedSeed(F&& f) {
+    if constexpr (P < SPACED_SEED_COUNT) {
+        f(SpacedSeed<P>{});
+        forEachSpacedSeed<P + 1>(f);
+    }
+}
+
+// "1101101,1110101" 또는 "all" → 활성 패턴 비트마스크 (알 수 없는 패턴이면 -1)
+int parseSpacedSeeds(const string& list) {
+    if (list == "all") return (1 << SPACED_SEED_COUNT) - 1;
+    int active = 0;
+    size_t start = 0;
+    while (start <= list.size()) {
+        size_t end = list.find(',', start);
+        if (end == string::npos) end = list.size();
+        string name = list.substr(start, end - start);
+        int found = -1;
+        for (int p = 0; p < SPACED_SEED_COUNT; ++p)
+            if (name == SPACED_SEED_PATTERNS[p]) found = p;
+        if (found < 0) return -1;
+        active |= 1 << found;
+        start = end + 1;
+    }
+    return active;
+}
+
+// mismatch 수 계산 커널: reference의 pos 위치와 read를 32염기 워드 단위로 XOR + popcount
+// 누적 mismatch가 limit을 넘는 즉시 중단 (이때 반환값은 limit 초과라는 것만 의미)
+using MismatchKernel = int (*)(const PackedRef&, size_t, const PackedRead&, int);
+
+__attribute__((always_inline)) inline int countMismatchFrom(const PackedRef& ref, size_t pos, const PackedRead& read,
+                                                            size_t w, int count, int limit) {
+    for (size_t nw = read.words.size(); w < nw; ++w) {
+        uint64_t x = (foldBases(ref.window(pos + 32 * w) ^ read.words[w]) | read.nmask[w]) & read.valid[w];
+        count += __builtin_popcountll(x);
+        if (count > limit) break;
+    }
     return count;
 }
 
-// 이진 탐색을 통한 접두사 검색 범위 찾기
-pair<int, int> findPrefixRange(const string& ref, const vector<int>& sa, const vector<int>& lcp, const string& pattern) {
-    int n = sa.size(), m = pattern.size();
-    int low = 0, high = n - 1;
+int countMismatchScalar(const PackedRef& ref, size_t pos, const PackedRead& read, int limit) {
+    return countMismatchFrom(ref, pos, read, 0, 0, limit);
+}
+
+#if defined(__x86_64__)
+// GCC 12의 avx512fintrin.h 내부에서 발생하는 잘못된 -Wmaybe-uninitialized 경고 억제
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+
+__attribute__((target("popcnt"))) int countMismatchPopcnt(const PackedRef& ref, size_t pos, const PackedRead& read, int limit) {
+    return countMismatchFrom(ref, pos, read, 0, 0, limit);
+}
+
+// AVX2: 4워드(128염기)씩 창 추출 + XOR, popcount는 니블 LUT(pshufb) + sad로 계산
+__attribute__((target("avx2,popcnt"))) int countMismatchAVX2(const PackedRef& ref, size_t pos, const PackedRead& read, int limit) {
+    const uint64_t* base = ref.words + (pos >> 5);
+    __m128i sl = _mm_cvtsi32_si128(2 * (pos & 31)), sr = _mm_cvtsi32_si128(64 - 2 * (pos & 31));
+    const __m256i low = _mm256_set1_epi64x(0x5555555555555555LL), nib = _mm256_set1_epi8(0x0f);
+    const __m256i lut = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+                                         0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+    size_t nw = read.words.size(), w = 0;
+    int count = 0;
+    for (; w + 4 <= nw; w += 4) {
+        __m256i a = _mm256_loadu_si256((const __m256i*)(base + w));
+        __m256i b = _mm256_loadu_si256((const __m256i*)(base + w + 1));
+        __m256i x = _mm256_xor_si256(_mm256_or_si256(_mm256_sll_epi64(a, sl), _mm256_srl_epi64(b, sr)),
+                                     _mm256_loadu_si256((const __m256i*)(read.words.data() + w)));
+        x = _mm256_and_si256(_mm256_or_si256(x, _mm256_srli_epi64(x, 1)), low);
+        x = _mm256_or_si256(x, _mm256_loadu_si256((const __m256i*)(read.nmask.data() + w)));
+        x = _mm256_and_si256(x, _mm256_loadu_si256((const __m256i*)(read.valid.data() + w)));
+        __m256i cnt = _mm256_add_epi8(_mm256_shuffle_epi8(lut, _mm256_and_si256(x, nib)),
+                                      _mm256_shuffle_epi8(lut, _mm256_and_si256(_mm256_srli_epi64(x, 4), nib)));
+        __m256i sum = _mm256_sad_epu8(cnt, _mm256_setzero_si256());
+        __m128i s2 = _mm_add_epi64(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
+        count += _mm_cvtsi128_si64(s2) + _mm_extract_epi64(s2, 1);
+        if (count > limit) return count;
+    }
+    return countMismatchFrom(ref, pos, read, w, count, limit);
+}
+
+// AVX-512: 8워드(256염기)씩 처리, VPOPCNTQ로 워드별 popcount
+__attribute__((target("avx512f,avx512vpopcntdq,popcnt"))) int countMismatchAVX512(const PackedRef& ref, size_t pos,
+                                                                                   const PackedRead& read, int limit) {
+    const uint64_t* base = ref.words + (pos >> 5);
+    __m128i sl = _mm_cvtsi32_si128(2 * (pos & 31)), sr = _mm_cvtsi32_si128(64 - 2 * (pos & 31));
+    const __m512i low = _mm512_set1_epi64(0x5555555555555555LL);
+    size_t nw = read.words.size(), w = 0;
+    int count = 0;
+    for (; w + 8 <= nw; w += 8) {
+        __m512i a = _mm512_loadu_si512(base + w), b = _mm512_loadu_si512(base + w + 1);
+        __m512i x = _mm512_xor_si512(_mm512_or_si512(_mm512_sll_epi64(a, sl), _mm512_srl_epi64(b, sr)),
+                                     _mm512_loadu_si512(read.words.data() + w));
+        x = _mm512_and_si512(_mm512_or_si512(x, _mm512_srli_epi64(x, 1)), low);
+        x = _mm512_or_si512(x, _mm512_loadu_si512(read.nmask.data() + w));
+        x = _mm512_and_si512(x, _mm512_loadu_si512(read.valid.data() + w));
+        count += _mm512_reduce_add_epi64(_mm512_popcnt_epi64(x));
+        if (count > limit) return count;
+    }
+    return countMismatchFrom(ref, pos, read, w, count, limit);
+}
+#pragma GCC diagnostic pop
+#endif
+
+// mismatch 커널 선택: "auto"면 CPU가 지원하는 가장 넓은 커널을 실행 시점에 고름
+MismatchKernel selectMismatchKernel(const string& want, string& name) {
+#if defined(__x86_64__)
+    __builtin_cpu_init();
+    bool avx512 = __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512vpopcntdq");
+    bool avx2 = __builtin_cpu_supports("avx2");
+    bool popcnt = __builtin_cpu_supports("popcnt");
+    if ((want == "auto" || want == "avx512") && avx512) return name = "avx512", countMismatchAVX512;
+    if ((want == "auto" || want == "avx512" || want == "avx2") && avx2) return name = "avx2", countMismatchAVX2;
+    if (want != "scalar" && popcnt) return name = "popcnt", countMismatchPopcnt;
+#endif
+    return name = "scalar", countMismatchScalar;
+}
+
+// 이진 탐색을 통한 접두사 검색 범위 찾기 (SA 구간 [lo, hi) 안에서만 탐색)
+pair<Pos, Pos> findPrefixRangeIn(const PackedRef& ref, PosView sa, string_view pattern, Pos lo, Pos hi) {
+    int m = pattern.size();
+    Pos low = lo, high = hi;
 
     // 왼쪽 경계 찾기
     while (low < high) {
-        int mid = (low + high) / 2;
+        Pos mid = (low + high) / 2;
         if (ref.compare(sa[mid], m, pattern) < 0)
             low = mid + 1;
         else
             high = mid;
     }
-    int left = low;
+    Pos left = low;
 
     // 오른쪽 경계 찾기
-    high = n;
+    high = hi;
     while (low < high) {
-        int mid = (low + high) / 2;
+        Pos mid = (low + high) / 2;
         if (ref.compare(sa[mid], m, pattern) <= 0)
             low = mid + 1;
         else
             high = mid;
     }
-    int right = low;
+    Pos right = low;
 
     return {left, right};
 }
 
-// FASTA 형식 reference 파일 로드
-string loadReference(const string& file) {
-    ifstream fin(file);
-    string line, seq;
-    while (getline(fin, line)) {
-        if (line[0] == '>') continue;
-        for (char c : line) {
-            char uc = toupper(c);
-            if (uc == 'A' || uc == 'T' || uc == 'G' || uc == 'C') seq += uc;
+// 이진 탐색을 통한 접두사 검색 범위 찾기
+pair<Pos, Pos> findPrefixRange(const PackedRef& ref, PosView sa, IntView lcp, string_view pattern) {
+    return findPrefixRangeIn(ref, sa, pattern, 0, sa.size());
+}
+
+// 묶음 이진 탐색에서 한 번에 진행하는 최대 패턴 수
+const int MAX_SEARCH_BATCH = 64;
+
+// 여러 패턴의 이진 탐색을 한 단계씩 번갈아 진행 (AMAC 방식의 interleaving)
+// 단계마다 모든 패턴의 sa[mid]를 먼저 prefetch → 그 위치의 reference 워드를 prefetch → 비교 순으로 처리하여
+// 한 패턴의 의존적인 캐시 미스를 기다리는 동안 다른 패턴들의 메모리 접근이 겹쳐 진행되도록 함
+// 결과는 패턴마다 findPrefixRange를 호출한 것과 같음 (count <= MAX_SEARCH_BATCH)
+// from: 모든 패턴의 왼쪽 경계가 이 이상임을 아는 경우 (예: 사전순으로 앞선 패턴의 왼쪽 경계)
+// mid < from인 단계는 비교 없이 오른쪽으로 감 (탐색 구간을 from부터 잡으면 mid 순서가 바뀌어 늘 캐시에 있던 상위 단계를 못 씀)
+void findPrefixRangeBatch(const PackedRef& ref, PosView sa, const string_view* patterns, int count, pair<Pos, Pos>* out,
+                          Pos from = 0) {
+    // 갈래 2k: k번째 패턴의 왼쪽 경계, 2k + 1: 오른쪽 경계
+    Pos low[2 * MAX_SEARCH_BATCH], high[2 * MAX_SEARCH_BATCH], mid[2 * MAX_SEARCH_BATCH];
+    int active[2 * MAX_SEARCH_BATCH];
+    int n = 0;
+    for (int l = 0; l < 2 * count; ++l) {
+        low[l] = 0;
+        high[l] = sa.size();
+        if (low[l] < high[l]) active[n++] = l;
+    }
+
+    while (n > 0) {
+        for (int a = 0; a < n; ++a) {
+            int l = active[a];
+            mid[l] = (low[l] + high[l]) / 2;
+            if (mid[l] >= from) __builtin_prefetch(sa.addr(mid[l]));
+        }
+        for (int a = 0; a < n; ++a) {
+            if (mid[active[a]] < from) continue;
+            Pos pos = sa[mid[active[a]]];
+            __builtin_prefetch(ref.words + (pos >> 5));
+        }
+        int next = 0;
+        for (int a = 0; a < n; ++a) {
+            int l = active[a];
+            string_view pattern = patterns[l >> 1];
+            int cmp = mid[l] < from ? -1 : ref.compare(sa[mid[l]], pattern.size(), pattern);
+            if ((l & 1) ? cmp <= 0 : cmp < 0)
+                low[l] = mid[l] + 1;
+            else
+                high[l] = mid[l];
+            if (low[l] < high[l]) active[next++] = l;
         }
+        n = next;
     }
-    return seq;
+
+    for (int k = 0; k < count; ++k) out[k] = {low[2 * k], low[2 * k + 1]};
 }
 
-// read 목록 로드 (1줄 1 read)
-vector<string> loadReads(const string& file) {
-    ifstream fin(file);
-    vector<string> reads;
-    string line;
-    while (getline(fin, line)) {
-        if (!line.empty()) reads.push_back(line);
+// LCP-LR 배열 구축: 이진 탐색 트리의 각 구간 (L, R)의 중점 M마다
+// llcp[M] = LCP(sa[L], sa[M]), rlcp[M] = LCP(sa[M], sa[R])를 저장 (L = -1, R = n은 경계로 보고 0)
+// 반환값은 LCP(sa[L], sa[R])
+int buildLCPLR(IntView lcp, Pos L, Pos R, Pos n, vector<int>& llcp, vector<int>& rlcp) {
+    if (R - L == 1) return (L >= 0 && R < n) ? lcp[L] : 0;
+    Pos M = (L + R) / 2;
+    llcp[M] = buildLCPLR(lcp, L, M, n, llcp, rlcp);
+    rlcp[M] = buildLCPLR(lcp, M, R, n, llcp, rlcp);
+    return min(llcp[M], rlcp[M]);
+}
+
+void buildLCPLR(IntView lcp, Pos n, vector<int>& llcp, vector<int>& rlcp) {
+    llcp.assign(n, 0);
+    rlcp.assign(n, 0);
+    if (n > 0) buildLCPLR(lcp, -1, n, n, llcp, rlcp);
+}
+
+// 접미사 pos와 pattern을 k번째 문자부터 비교하여 공통 접두사 길이를 k에 갱신
+// 반환값: pattern 길이만큼 일치하면 0, 접미사가 작으면 음수, 크면 양수
+int comparePrefixFrom(const PackedRef& ref, Pos pos, string_view pattern, int& k) {
+    int m = pattern.size();
+    Pos n = ref.size();
+    while (k < m && pos + k < n && ref[pos + k] == pattern[k]) ++k;
+    if (k == m) return 0;
+    if (pos + k >= n) return -1;
+    return ref[pos + k] < pattern[k] ? -1 : 1;
+}
+
+// Manber-Myers (mlr) 경계 탐색: 양 끝 경계와 pattern의 LCP(l, r)를 유지하고
+// LCP-LR로 이미 아는 문자를 건너뛰어 전체 문자 비교를 O(m + log n)으로 줄임
+// upper=false면 접두사가 pattern 이상인 첫 위치, true면 pattern 초과인 첫 위치
+Pos mlrBound(const PackedRef& ref, PosView sa, IntView llcp, IntView rlcp, string_view pattern, bool upper) {
+    int m = pattern.size();
+    Pos L = -1, R = sa.size();
+    int l = 0, r = 0;
+    while (R - L > 1) {
+        Pos M = (L + R) / 2;
+        int k;
+        if (l >= r) {
+            int ll = min(llcp[M], m);
+            if (ll > l) { L = M; continue; }
+            if (ll < l) { R = M; r = ll; continue; }
+            k = l;
+        } else {
+            int rl = min(rlcp[M], m);
+            if (rl > r) { R = M; continue; }
+            if (rl < r) { L = M; l = rl; continue; }
+            k = r;
+        }
+        int cmp = comparePrefixFrom(ref, sa[M], pattern, k);
+        if (cmp < 0 || (cmp == 0 && upper)) {
+            L = M;
+            l = k;
+        } else {
+            R = M;
+            r = k;
+        }
     }
-    return reads;
+    return R;
 }
 
-// 메인 함수: 전체 파이프라인 실행
-int main() {
-    auto total_start = high_resolution_clock::now();
+// LCP-LR 기반 접두사 검색 범위 찾기 (findPrefixRange와 같은 결과)
+pair<Pos, Pos> findPrefixRangeLCP(const PackedRef& ref, PosView sa, IntView llcp, IntView rlcp, string_view pattern) {
+    return {mlrBound(ref, sa, llcp, rlcp, pattern, false), mlrBound(ref, sa, llcp, rlcp, pattern, true)};
+}
 
-    auto t1 = high_resolution_clock::now();
-    string reference = loadReference("reference.txt");
-    vector<string> reads = loadReads("reads.txt");
-    auto t2 = high_resolution_clock::now();
+// k-mer 직접 조회 테이블 구축 (SA 없이 reference 순차 스캔만으로 계산)
+// start[c] = k-mer c 이상인 첫 접미사의 SA 순위 (c = 0 .. 4^k, start[4^k] = n)
+// 길이 k 미만의 끝 접미사 s는 s 뒤를 A로 채운 k-mer 바로 앞에 정렬됨
+vector<Pos> buildKmerTable(string_view ref, int k) {
+    size_t size = (size_t)1 << (2 * k);
+    uint64_t mask = size - 1;
+    Pos n = ref.size();
+    vector<Pos> start(size + 1, 0);
 
-    cout << "Reference length (N): " << reference.size() << " bp\n";
-    cout << "Number of reads (M): " << reads.size() << " reads\n";
-    printTime("[1] 입력 로딩:", t1, t2);
+    uint64_t code = 0;
+    for (Pos p = 0; p < min<Pos>(n, k); ++p) code = (code << 2) | baseCode(ref[p]);
+    for (Pos p = 0; p + k <= n; ++p) {
+        start[code + 1]++;
+        if (p + k < n) code = ((code << 2) | baseCode(ref[p + k])) & mask;
+    }
+    for (Pos p = max<Pos>(0, n - k + 1); p < n; ++p) {
+        uint64_t y = 0;
+        for (Pos i = p; i < n; ++i) y = (y << 2) | baseCode(ref[i]);
+        start[y << (2 * (k - (n - p)))]++;
+    }
 
-    t1 = high_resolution_clock::now();
-    vector<int> sa = buildSuffixArray(reference);
-    vector<int> lcp = buildLCPArray(reference + '\0', sa);
-    t2 = high_resolution_clock::now();
-    printTime("[2] SA + LCP 생성:", t1, t2);
+    for (size_t c = 1; c <= size; ++c) start[c] += start[c - 1];
+    return start;
+}
 
-    t1 = high_resolution_clock::now();
-    ofstream fout("result.txt");
+// k-mer 테이블로 첫 k 염기의 SA 구간을 바로 구하고, 시드가 더 길 때만 그 구간 안에서 이진 탐색
+pair<Pos, Pos> findPrefixRangeKmer(const PackedRef& ref, PosView sa, IntView lcp, PosView kmerStart, int k, string_view pattern) {
+    int m = pattern.size();
+    if (m < k) return findPrefixRange(ref, sa, lcp, pattern);
+
+    uint64_t code = 0;
+    for (int i = 0; i < k; ++i) {
+        int b = baseCode(pattern[i]);
+        if (b < 0) return {0, 0}; // ACGT 외 문자는 reference에 없으므로 후보 없음
+        code = (code << 2) | b;
+    }
+    Pos lo = kmerStart[code], hi = kmerStart[code + 1];
+    if (m > k) return findPrefixRangeIn(ref, sa, pattern, lo, hi);
+
+    // 구간 끝에 놓일 수 있는 길이 k 미만 접미사 제외
+    while (hi > lo && sa[hi - 1] + k > (Pos)ref.size()) --hi;
+    return {lo, hi};
+}
+
+// FM-index: BWT와 occ 체크포인트를 캐시 라인(64바이트) 블록 하나에 함께 두어 occ 조회가 캐시 미스 한 번으로 끝나도록 함
+// 블록 = 블록 시작 전까지의 염기별 누적 횟수 4개 (16바이트) + 2비트 BWT 192염기 (48바이트)
+// 40비트 빌드는 행 수가 2^32를 넘을 수 있으므로 누적 횟수를 64비트로 (32바이트) 두고 블록당 128염기
+#ifdef ALIGNER_POS40
+using RowCount = uint64_t;
+const int FM_BLOCK_BASES = 128;
+#else
+using RowCount = uint32_t;
+const int FM_BLOCK_BASES = 192;
+#endif
+const int FM_SA_SAMPLE = 32;  // SA 값이 이 간격의 배수인 행만 SA 값을 저장
+
+struct alignas(64) OccBlock {
+    RowCount count[4];
+    uint64_t bwt[FM_BLOCK_BASES / 32];
+};
+static_assert(sizeof(OccBlock) == 64, "OccBlock은 캐시 라인 하나 크기여야 함");
+
+// 행 = reference 끝에 '$'를 붙인 문자열의 접미사 순서 (행 0 = "$", 행 i + 1 = SA[i])
+// BWT의 '$' 자리는 A로 저장하고 occ에서 보정
+struct FMIndex {
+    const OccBlock* blocks = nullptr;
+    uint64_t rows = 0;
+    uint64_t dollarRow = 0;        // BWT 값이 '$'인 행 (SA 값 0)
+    uint64_t C[4] = {};            // 염기 c보다 작은 문자('$' 포함)로 시작하는 접미사 수
+    const uint64_t* marks = nullptr;  // 행마다 1비트: SA 값이 샘플되었는지
+    const RowCount* markRank = nullptr;  // 64행마다 그 앞까지 샘플된 행 수
+    PosView samples;               // 샘플된 행의 SA 값 (행 순서)
+
+    int bwtCode(uint64_t row) const {
+        return (blocks[row / FM_BLOCK_BASES].bwt[row % FM_BLOCK_BASES / 32] >> (62 - 2 * (row & 31))) & 3;
+    }
+
+    // BWT[0, i)에서 염기 c의 등장 횟수
+    uint64_t occ(int c, uint64_t i) const {
+        const OccBlock& b = blocks[i / FM_BLOCK_BASES];
+        uint64_t r = i % FM_BLOCK_BASES, cnt = b.count[c];
+        uint64_t pattern = 0x5555555555555555ULL * c;
+        for (uint64_t w = 0; w * 32 < r; ++w) {
+            uint64_t x = b.bwt[w] ^ pattern;
+            uint64_t eq = ~(x | (x >> 1)) & 0x5555555555555555ULL;
+            if (r - w * 32 < 32) eq &= ~0ULL << (64 - 2 * (r - w * 32));
+            cnt += __builtin_popcountll(eq);
+        }
+        return cnt - (c == 0 && dollarRow < i);
+    }
+
+    // backward search: pattern의 SA 구간 (findPrefixRange와 같은 SA 인덱스 기준)
+    pair<Pos, Pos> search(string_view pattern) const {
+        uint64_t l = 0, r = rows;
+        for (size_t i = pattern.size(); i-- > 0 && l < r;) {
+            int c = baseCode(pattern[i]);
+            if (c < 0) return {0, 0};
+            l = C[c] + occ(c, l);
+            r = C[c] + occ(c, r);
+        }
+        if (l >= r) return {0, 0};
+        return {(Pos)l - 1, (Pos)r - 1};  // 행 0('$')은 SA에 없으므로 한 칸 당김
+    }
+
+    // SA 인덱스 j의 reference 위치: 샘플된 행이 나올 때까지 LF로 한 칸씩 앞으로 이동 (최대 FM_SA_SAMPLE - 1번)
+    Pos locate(Pos j) const {
+        uint64_t row = j + 1;
+        int steps = 0;
+        while (!(marks[row / 64] >> (row % 64) & 1)) {
+            int c = bwtCode(row);
+            row = C[c] + occ(c, row);
+            ++steps;
+        }
+        uint64_t rank = markRank[row / 64] + __builtin_popcountll(marks[row / 64] & ((1ULL << (row % 64)) - 1));
+        return samples[rank] + steps;
+    }
+};
+
+// FM-index 저장 공간 (메모리에 구축할 때 사용)
+struct FMStorage {
+    vector<OccBlock> blocks;
+    vector<uint64_t> marks;
+    vector<RowCount> markRank;
+    PosStorage samples;
+};
+
+// 기존 SA로부터 FM-index 구축 (BWT[행] = 행 접미사 바로 앞 염기)
+void buildFMIndex(const string& ref, PosView sa, FMIndex& fm, FMStorage& st) {
+    uint64_t rows = sa.size() + 1;
+    auto saAt = [&](uint64_t row) -> uint64_t { return row == 0 ? sa.size() : sa[row - 1]; };
+
+    st.blocks.assign(rows / FM_BLOCK_BASES + 1, OccBlock{});
+    st.marks.assign(rows / 64 + 1, 0);
+    st.markRank.assign(rows / 64 + 1, 0);
+    vector<Pos> samples;
+    samples.reserve(rows / FM_SA_SAMPLE + 1);
+    RowCount count[4] = {};
+    for (uint64_t row = 0; row < rows; ++row) {
+        OccBlock& b = st.blocks[row / FM_BLOCK_BASES];
+        if (row % FM_BLOCK_BASES == 0) memcpy(b.count, count, sizeof(count));
+        uint64_t pos = saAt(row);
+        int c = 0;
+        if (pos == 0) fm.dollarRow = row;
+        else c = baseCode(ref[pos - 1]);
+        b.bwt[row % FM_BLOCK_BASES / 32] |= (uint64_t)c << (62 - 2 * (row & 31));
+        count[c]++;
+        if (pos % FM_SA_SAMPLE == 0) {
+            st.marks[row / 64] |= 1ULL << (row % 64);
+            samples.push_back(pos);
+        }
+    }
+    if (rows % FM_BLOCK_BASES == 0) memcpy(st.blocks.back().count, count, sizeof(count));
+    for (size_t w = 1; w < st.marks.size(); ++w) st.markRank[w] = st.markRank[w - 1] + __builtin_popcountll(st.marks[w - 1]);
+
+    count[0]--;  // '$' 자리에 넣은 A 제외
+    fm.C[0] = 1;
+    for (int c = 1; c < 4; ++c) fm.C[c] = fm.C[c - 1] + count[c - 1];
+    fm.rows = rows;
+    fm.blocks = st.blocks.data();
+    fm.marks = st.marks.data();
+    fm.markRank = st.markRank.data();
+    st.samples = packPositions(move(samples));
+    fm.samples = viewPositions(st.samples);
+}
+
+// FM-index 크기 (바이트)
+uint64_t fmIndexBytes(const FMIndex& fm) {
+    return (fm.rows / FM_BLOCK_BASES + 1) * sizeof(OccBlock) + (fm.rows / 64 + 1) * (sizeof(uint64_t) + sizeof(RowCount)) +
+           posArrayBytes(fm.samples.size());
+}
+
+// reference 구성: contig 표 (이어 붙인 서열 안의 시작 위치, 길이)와 N 구간 목록
+// contig들은 구분 문자 없이 이어 붙이고 (2비트 알파벳에 여분 문자가 없음) 경계를 넘는 후보는 inside()로 걸러냄
+// N 등 ACGT 외 염기는 좌표가 어긋나지 않도록 자리를 유지하되 의사 난수 염기로 채우고 (poly-A 시드 폭주 방지) 구간만 기록
+struct Contig {
+    string name;      // '>' 뒤 첫 단어 (헤더 없는 파일은 빈 이름)
+    uint64_t start, length;
+};
+
+struct NRun {
+    uint64_t start, length;
+};
+
+// 정수를 to_chars로 out 뒤에 덧붙임 (to_string과 달리 임시 문자열을 만들지 않음)
+template <class T>
+inline void appendInt(string& out, T v) {
+    char buf[24];
+    out.append(buf, to_chars(buf, buf + sizeof(buf), v).ptr);
+}
+
+struct RefLayout {
+    vector<Contig> contigs;
+    vector<NRun> nRuns;   // 시작 위치 순
+
+    // pos가 속한 contig 번호
+    int contigOf(uint64_t pos) const {
+        auto it = upper_bound(contigs.begin(), contigs.end(), pos, [](uint64_t p, const Contig& c) { return p < c.start; });
+        return int(it - contigs.begin()) - 1;
+    }
+
+    // [pos, pos + len)이 한 contig 안에 있고 N 구간과 겹치지 않는지
+    bool inside(uint64_t pos, uint64_t len) const {
+        if (contigs.size() > 1) {
+            const Contig& c = contigs[contigOf(pos)];
+            if (pos + len > c.start + c.length) return false;
+        }
+        if (nRuns.empty()) return true;
+        auto it = upper_bound(nRuns.begin(), nRuns.end(), pos, [](uint64_t p, const NRun& r) { return p < r.start + r.length; });
+        return it == nRuns.end() || it->start >= pos + len;
+    }
+
+    // N이 아닌 pos를 포함하는, N 구간 사이의 [시작, 끝) (뒤에 N 구간이 없으면 끝은 UINT64_MAX)
+    pair<uint64_t, uint64_t> nGap(uint64_t pos) const {
+        auto it = upper_bound(nRuns.begin(), nRuns.end(), pos, [](uint64_t p, const NRun& r) { return p < r.start + r.length; });
+        uint64_t start = it == nRuns.begin() ? 0 : prev(it)->start + prev(it)->length;
+        return {start, it == nRuns.end() ? UINT64_MAX : it->start};
+    }
+
+    // 출력용 좌표: "contig:contig 안 위치" (이름 없는 단일 서열이면 위치만)
+    void format(string& out, uint64_t pos) const {
+        int c = contigs.empty() ? -1 : contigOf(pos);
+        if (c < 0 || contigs[c].name.empty()) {
+            appendInt(out, pos);
+            return;
+        }
+        out += contigs[c].name;
+        out += ':';
+        appendInt(out, pos - contigs[c].start);
+    }
 
-    #pragma omp parallel for schedule(dynamic)
-    for (int i = 0; i < reads.size(); ++i) {
-        const string& read = reads[i];
-        auto [l, r] = findPrefixRange(reference, sa, lcp, read.substr(0, SEED_LEN));
+    uint64_t nBases() const {
+        uint64_t n = 0;
+        for (const NRun& r : nRuns) n += r.length;
+        return n;
+    }
+};
+
+// 16바이트가 모두 대문자 ACGT인지 (SSE2 비교 4번 + movemask)
+inline bool allUpperACGT16(const char* p) {
+#if defined(__x86_64__)
+    __m128i v = _mm_loadu_si128((const __m128i*)p);
+    __m128i m = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('A')), _mm_cmpeq_epi8(v, _mm_set1_epi8('C'))),
+                             _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('G')), _mm_cmpeq_epi8(v, _mm_set1_epi8('T'))));
+    return _mm_movemask_epi8(m) == 0xFFFF;
+#else
+    for (int i = 0; i < 16; ++i)
+        if (p[i] != 'A' && p[i] != 'C' && p[i] != 'G' && p[i] != 'T') return false;
+    return true;
+#endif
+}
 
-        int bestMismatch = MAX_ERROR + 1, bestPos = -1;
+// FASTA 형식 reference 파일 로드 (여러 레코드 지원, 레코드마다 contig 하나)
+// 파일을 큰 블록 단위로 읽고, 서열 줄은 16바이트씩 대문자 ACGT인지 SIMD로 확인해 그대로 복사하며 나머지만 한 글자씩 처리
+string loadReference(const string& file, RefLayout& layout) {
+    layout = RefLayout();
+    string seq;
+    FILE* fp = fopen(file.c_str(), "rb");
+    if (!fp) {
+        cerr << "reference 파일을 열 수 없음: " << file << "\n";
+        return seq;
+    }
+    struct stat st;
+    if (fstat(fileno(fp), &st) == 0) seq.reserve(st.st_size);
 
-        for (int j = l; j < r; ++j) {
-            int pos = sa[j];
-            if (pos + read.size() > reference.size()) continue;
-            if (!spacedSeedMatch(reference, read, pos)) continue;
+    // 문자 분류: 0 = 무시 (공백, 줄바꿈 등), 'A'/'C'/'G'/'T' = 염기, 'N' = 그 외 문자 (IUPAC 모호 염기 등)
+    char kind[256] = {};
+    for (int c = 'A'; c <= 'Z'; ++c) kind[c] = kind[c + 32] = 'N';
+    for (char c : {'A', 'C', 'G', 'T'}) kind[(unsigned char)c] = kind[(unsigned char)(c + 32)] = c;
+    kind[(unsigned char)'-'] = kind[(unsigned char)'*'] = 'N';
 
-            string refseg = reference.substr(pos, read.size());
-            int mismatch = countMismatch(read, refseg);
+    uint32_t rng = 2463534242u;  // N 자리 채움용 (xorshift, 실행마다 같은 결과)
+    auto addN = [&]() {
+        uint64_t pos = seq.size();
+        if (!layout.nRuns.empty() && layout.nRuns.back().start + layout.nRuns.back().length == pos) layout.nRuns.back().length++;
+        else layout.nRuns.push_back({pos, 1});
+        rng ^= rng << 13, rng ^= rng >> 17, rng ^= rng << 5;
+        seq += "ACGT"[rng & 3];
+    };
+    auto endContig = [&]() {
+        if (layout.contigs.empty()) return;
+        Contig& c = layout.contigs.back();
+        c.length = seq.size() - c.start;
+        if (c.length == 0) layout.contigs.pop_back();
+    };
 
-            if (mismatch < bestMismatch) {
-                bestMismatch = mismatch;
-                bestPos = pos;
-                if (mismatch == 0) break;
+    const size_t BUF = 1 << 22;
+    vector<char> buf(BUF + 16);
+    string header;
+    bool inHeader = false, lineStart = true;
+    size_t got;
+    while ((got = fread(buf.data(), 1, BUF, fp)) > 0) {
+        const char* p = buf.data();
+        const char* end = p + got;
+        while (p < end) {
+            if (inHeader) {
+                const char* nl = (const char*)memchr(p, '\n', end - p);
+                header.append(p, nl ? nl : end);
+                if (!nl) {
+                    p = end;
+                    break;
+                }
+                p = nl + 1;
+                inHeader = false;
+                lineStart = true;
+                size_t w = header.find_first_of(" \t\r");
+                layout.contigs.push_back({header.substr(0, w), seq.size(), 0});
+                header.clear();
+                continue;
             }
+            if (lineStart && *p == '>') {
+                endContig();
+                inHeader = true;
+                ++p;
+                continue;
+            }
+            if (layout.contigs.empty()) layout.contigs.push_back({"", 0, 0});
+            const char* nl = (const char*)memchr(p, '\n', end - p);
+            const char* lineEnd = nl ? nl : end;
+            while (p + 16 <= lineEnd && allUpperACGT16(p)) {
+                seq.append(p, 16);
+                p += 16;
+            }
+            for (; p < lineEnd; ++p) {
+                char k = kind[(unsigned char)*p];
+                if (k == 'N') addN();
+                else if (k) seq += k;
+            }
+            lineStart = nl != nullptr;
+            if (nl) ++p;
         }
+    }
+    fclose(fp);
+    endContig();
+    return seq;
+}
 
-        #pragma omp critical
-        {
-            fout << "read index: " << i << " -> ";
-            if (bestPos != -1 && bestMismatch <= MAX_ERROR)
-                fout << "pos: " << bestPos << ", mismatch: " << bestMismatch << "\n";
-            else
-                fout << "no match\n";
+// read 파일 파서: 1줄 1 read 형식과 FASTQ(@이름 / 서열 / + / 품질 4줄) 형식을 첫 글자로 자동 판별
+class ReadParser {
+    ifstream fin;
+    string line;
+    bool fastq = false, first = true;
+
+public:
+    explicit ReadParser(const string& file) : fin(file) {}
+    bool isOpen() const { return fin.is_open(); }
+
+    // 다음 read 서열을 out 뒤에 덧붙임 (더 없으면 false)
+    bool next(string& out) {
+        while (getline(fin, line)) {
+            if (line.empty()) continue;
+            if (first) {
+                fastq = line[0] == '@';
+                first = false;
+            }
+            if (!fastq) {
+                out += line;
+                return true;
+            }
+            if (line[0] != '@') continue;
+            if (!getline(fin, line)) return false;
+            out += line;
+            getline(fin, line); // '+'
+            getline(fin, line); // 품질
+            return true;
         }
+        return false;
+    }
+};
+
+// read 목록 로드 (1줄 1 read 또는 FASTQ)
+vector<string> loadReads(const string& file) {
+    ReadParser parser(file);
+    vector<string> reads;
+    string read;
+    while (parser.next(read)) {
+        reads.push_back(move(read));
+        read.clear();
     }
+    return reads;
+}
 
-    fout.close();
-    t2 = high_resolution_clock::now();
-    printTime("[3] 정렬 수행 완료:", t1, t2);
+// SA 인덱스: reference (2비트 압축), SA, LCP에 대한 읽기 전용 뷰
+// 메모리에서 직접 구축하면 *Storage가, 인덱스 파일을 불러오면 mmap 영역이 실제 데이터를 소유
+// 시드 검색 엔진: SA 이진 탐색 계열 또는 FM-index backward search
+enum class IndexBackend { SA, FM };
+
+struct SAIndex {
+    IndexBackend backend = IndexBackend::SA;
+    PackedRef reference;
+    RefLayout layout;    // contig 표와 N 구간
+    PosView sa;          // FM 백엔드에서는 비어 있음
+    IntView lcp;
+    FMIndex fm;
+    int kmerK = 0;       // k-mer 테이블의 k (0이면 테이블 없음)
+    PosView kmerStart;
+    IntView llcp, rlcp;  // LCP-LR 배열 (비어 있으면 일반 이진 탐색)
+    PosView spaced[SPACED_SEED_COUNT];  // 패턴별 spaced seed 인덱스 (비어 있으면 없음)
+
+    vector<uint64_t> refStorage;
+    PosStorage saStorage, kmerStorage;
+    vector<int> lcpStorage, llcpStorage, rlcpStorage;
+    PosStorage spacedStorage[SPACED_SEED_COUNT];
+    FMStorage fmStorage;
+    void* mapAddr = nullptr;
+    size_t mapSize = 0;
+
+    SAIndex() = default;
+    SAIndex(const SAIndex&) = delete;
+    SAIndex& operator=(const SAIndex&) = delete;
+    ~SAIndex() {
+        if (mapAddr) munmap(mapAddr, mapSize);
+    }
+};
+
+// reference로부터 SA, LCP (kmerK > 0이면 k-mer 테이블, lcpSearch면 LCP-LR 배열까지)를 메모리에 구축
+// 구축이 끝나면 문자열 reference는 버리고 2비트 압축본만 남김
+// FM 백엔드는 SA로 FM-index를 만든 뒤 SA를 버림 (LCP, k-mer 테이블, LCP-LR은 만들지 않음, keepSA면 비교용으로 SA만 남김)
+// threads: SA(--sa=parallel)와 LCP 구축에 쓸 스레드 수
+void buildIndex(SAIndex& idx, string reference, SABuilder builder, int threads, int kmerK, bool lcpSearch,
+                IndexBackend backend, bool keepSA = false) {
+    auto t1 = high_resolution_clock::now();
+    vector<Pos> sa = buildSuffixArray(reference, builder, threads);
+    auto t2 = high_resolution_clock::now();
+    printTime("  SA:", t1, t2);
+    idx.refStorage = packSequence(reference);
+    idx.reference = PackedRef(idx.refStorage.data(), reference.size());
+    idx.backend = backend;
+    // 여기부터 SA는 POS_BYTES바이트로 저장한 것만 씀 (40비트 빌드는 int64 배열을 버림)
+    idx.saStorage = packPositions(move(sa));
+    if (backend != IndexBackend::FM)
+        idx.lcpStorage = threads > 1 ? buildLCPArrayParallel(reference, viewPositions(idx.saStorage), threads)
+                                     : buildLCPArray(reference, viewPositions(idx.saStorage));
+    if (backend == IndexBackend::FM) {
+        buildFMIndex(reference, viewPositions(idx.saStorage), idx.fm, idx.fmStorage);
+        printTime("  FM-index:", t2, high_resolution_clock::now());
+        if (keepSA) idx.sa = viewPositions(idx.saStorage);
+        else PosStorage().swap(idx.saStorage);
+        return;
+    }
+    printTime("  LCP:", t2, high_resolution_clock::now());
+    idx.sa = viewPositions(idx.saStorage);
+    idx.lcp = idx.lcpStorage;
+    if (kmerK > 0) {
+        idx.kmerStorage = packPositions(buildKmerTable(reference, kmerK));
+        idx.kmerK = kmerK;
+        idx.kmerStart = viewPositions(idx.kmerStorage);
+    }
+    if (lcpSearch) {
+        buildLCPLR(idx.lcp, idx.sa.size(), idx.llcpStorage, idx.rlcpStorage);
+        idx.llcp = idx.llcpStorage;
+        idx.rlcp = idx.rlcpStorage;
+    }
+}
+
+// 활성 패턴 중 인덱스가 없는 것만 packed reference로부터 구축
+void buildSpacedSeedIndexes(SAIndex& idx, int active) {
+    forEachSpacedSeed([&](auto seed) {
+        constexpr int P = decltype(seed)::id;
+        if (!(active >> P & 1) || idx.spaced[P].size() > 0) return;
+        idx.spacedStorage[P] = packPositions(decltype(seed)::build(idx.reference));
+        idx.spaced[P] = viewPositions(idx.spacedStorage[P]);
+    });
+}
+
+// 시드의 SA 구간 검색 (k-mer 테이블이 있으면 사용)
+pair<Pos, Pos> seedRange(const SAIndex& idx, string_view seed) {
+    if (idx.backend == IndexBackend::FM) return idx.fm.search(seed);
+    if (idx.kmerK > 0 && (int)seed.size() >= idx.kmerK)
+        return findPrefixRangeKmer(idx.reference, idx.sa, idx.lcp, idx.kmerStart, idx.kmerK, seed);
+    if (idx.llcp.size() > 0) return findPrefixRangeLCP(idx.reference, idx.sa, idx.llcp, idx.rlcp, seed);
+    return findPrefixRange(idx.reference, idx.sa, idx.lcp, seed);
+}
+
+// seedRange 구간 안 j번째 항목의 reference 위치
+Pos seedPos(const SAIndex& idx, Pos j) { return idx.backend == IndexBackend::FM ? idx.fm.locate(j) : idx.sa[j]; }
+
+// 시드 정렬 키: 첫 SEED_LEN 염기의 2비트 코드 (키 순서 = 사전순), ACGT 외 문자가 있거나 짧으면 SEED_UNSORTABLE
+const uint32_t SEED_UNSORTABLE = 1u << (2 * SEED_LEN);
+static_assert(2 * SEED_LEN + 1 <= 22, "시드 키는 radix 정렬 두 번(11비트씩)에 들어가야 함");
+
+uint32_t seedKey(string_view seed) {
+    if (seed.size() < (size_t)SEED_LEN) return SEED_UNSORTABLE;
+    uint32_t key = 0;
+    for (int i = 0; i < SEED_LEN; ++i) {
+        int c = baseCode(seed[i]);
+        if (c < 0) return SEED_UNSORTABLE;
+        key = key << 2 | c;
+    }
+    return key;
+}
+
+// items = (시드 키 << 32 | 번호)를 키 순서로 안정 정렬 (LSD radix, 11비트씩 두 번), tmp는 재사용 버퍼
+void radixSortSeeds(vector<uint64_t>& items, vector<uint64_t>& tmp) {
+    const int BITS = 11;
+    tmp.resize(items.size());
+    for (int shift = 32; shift < 32 + 2 * BITS; shift += BITS) {
+        uint32_t count[(1 << BITS) + 1] = {};
+        for (uint64_t x : items) count[(x >> shift & ((1 << BITS) - 1)) + 1]++;
+        for (int b = 0; b < 1 << BITS; ++b) count[b + 1] += count[b];
+        for (uint64_t x : items) tmp[count[x >> shift & ((1 << BITS) - 1)]++] = x;
+        items.swap(tmp);
+    }
+}
+
+// 묶음 이진 탐색을 쓸 수 있는지 (k-mer 테이블/LCP-LR/FM-index가 있으면 seedRange가 그쪽을 쓰므로 제외)
+bool batchSearchable(const SAIndex& idx) {
+    return idx.backend == IndexBackend::SA && idx.kmerK == 0 && idx.llcp.size() == 0;
+}
+
+// 인덱스 파일 형식 (리틀 엔디언, 각 구역은 INDEX_ALIGN 바이트 경계에 정렬)
+// 위치 배열(SA, k-mer 테이블, spaced seed 인덱스, FM SA 샘플)은 항목당 posBytes바이트 (posArrayBytes)
+// [헤더][reference (2비트 압축, uint64 × (refLen + 31) / 32 + 1)][SA (위치 × refLen)][LCP (int32 × refLen)]
+// [k-mer 테이블 (위치 × (4^kmerK + 1), kmerK > 0일 때만)][LLCP, RLCP (int32 × refLen, lcplrLen > 0일 때만)]
+// [패턴별 spaced seed 인덱스 (위치 × spacedLen[p], 구축한 패턴만)]
+// FM 백엔드는 SA/LCP 대신 [occ 블록 (64바이트 × (fmRows / FM_BLOCK_BASES + 1))][샘플 표시 비트 (uint64 × (fmRows / 64 + 1))]
+// [샘플 표시 누적 수 (RowCount × (fmRows / 64 + 1))][샘플된 SA 값 (위치 × fmSamplesLen)]
+// [contig 표 (contig마다 시작 uint64, 길이 uint64, 이름 길이 uint32, 이름)][N 구간 (시작 uint64, 길이 uint64 × nRunCount)]
+const char INDEX_MAGIC[8] = {'S', 'R', 'A', 'I', 'D', 'X', '\0', '\0'};
+const uint32_t INDEX_VERSION = 8;
+const uint64_t INDEX_ALIGN = 4096;
+
+struct IndexHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t headerSize;
+    uint64_t refLen;
+    uint64_t saLen;
+    uint64_t lcpLen;
+    uint32_t seedLen;     // 구축 당시 SEED_LEN
+    uint32_t maxError;    // 구축 당시 MAX_ERROR
+    uint64_t refOffset;
+    uint64_t saOffset;
+    uint64_t lcpOffset;
+    uint32_t kmerK;       // k-mer 테이블의 k (0이면 없음)
+    uint32_t posBytes;    // 구축 당시 POS_BYTES (32비트/40비트 빌드가 서로의 인덱스를 읽지 않도록)
+    uint64_t kmerLen;
+    uint64_t kmerOffset;
+    uint64_t lcplrLen;    // LCP-LR 배열 길이 (0이면 없음)
+    uint64_t llcpOffset;
+    uint64_t rlcpOffset;
+    char spacedPattern[SPACED_SEED_COUNT][8];  // 구축 당시 패턴 (컴파일된 패턴이 바뀌었는지 확인용)
+    uint64_t spacedLen[SPACED_SEED_COUNT];
+    uint64_t spacedOffset[SPACED_SEED_COUNT];
+    uint32_t backend;       // IndexBackend
+    uint32_t fmSampleRate;  // 구축 당시 FM_SA_SAMPLE
+    uint64_t fmRows;        // FM-index 행 수 (refLen + 1, SA 백엔드면 0)
+    uint64_t fmDollarRow;
+    uint64_t fmC[4];
+    uint64_t fmBlockOffset;
+    uint64_t fmMarkOffset;
+    uint64_t fmRankOffset;
+    uint64_t fmSamplesLen;
+    uint64_t fmSamplesOffset;
+    uint64_t contigCount;
+    uint64_t contigBytes;
+    uint64_t contigOffset;
+    uint64_t nRunCount;
+    uint64_t nRunOffset;
+    uint64_t fileSize;
+    uint64_t checksum;    // 헤더 뒤 전체 payload의 체크섬
+};
+
+uint64_t alignUp(uint64_t x, uint64_t a) { return (x + a - 1) / a * a; }
+
+// 압축 reference 구역의 워드 수
+uint64_t packedWords(uint64_t refLen) { return (refLen + 31) / 32 + 1; }
+
+// FM-index 구역의 occ 블록 수, 샘플 표시 워드 수
+uint64_t fmBlockCount(uint64_t rows) { return rows == 0 ? 0 : rows / FM_BLOCK_BASES + 1; }
+uint64_t fmMarkWords(uint64_t rows) { return rows == 0 ? 0 : rows / 64 + 1; }
+
+// 64비트 워드 단위 FNV-1a 변형 (인덱스 무결성 확인용)
+uint64_t checksumBytes(const void* data, size_t size, uint64_t h = 1469598103934665603ULL) {
+    const unsigned char* p = (const unsigned char*)data;
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8) {
+        uint64_t w;
+        memcpy(&w, p + i, 8);
+        h = (h ^ w) * 1099511628211ULL;
+    }
+    for (; i < size; ++i) h = (h ^ p[i]) * 1099511628211ULL;
+    return h;
+}
+
+// contig 표 직렬화 / 복원
+string serializeContigs(const RefLayout& layout) {
+    string blob;
+    for (const Contig& c : layout.contigs) {
+        uint32_t nameLen = c.name.size();
+        blob.append((const char*)&c.start, sizeof(c.start));
+        blob.append((const char*)&c.length, sizeof(c.length));
+        blob.append((const char*)&nameLen, sizeof(nameLen));
+        blob += c.name;
+    }
+    return blob;
+}
+
+bool parseContigs(string_view blob, uint64_t count, RefLayout& layout) {
+    layout.contigs.clear();
+    size_t at = 0;
+    for (uint64_t i = 0; i < count; ++i) {
+        Contig c;
+        uint32_t nameLen;
+        if (at + 20 > blob.size()) return false;
+        memcpy(&c.start, blob.data() + at, 8);
+        memcpy(&c.length, blob.data() + at + 8, 8);
+        memcpy(&nameLen, blob.data() + at + 16, 4);
+        at += 20;
+        if (at + nameLen > blob.size()) return false;
+        c.name = string(blob.substr(at, nameLen));
+        at += nameLen;
+        layout.contigs.push_back(move(c));
+    }
+    return at == blob.size();
+}
+
+// 헤더에 기록된 구역들의 체크섬 계산 (구축/검증 공통)
+uint64_t indexChecksum(const IndexHeader& h, const uint64_t* ref, const char* sa, const int* lcp, const char* kmer,
+                       const int* llcp, const int* rlcp, const char* const* spaced, const FMIndex& fm,
+                       string_view contigBlob, const NRun* nRuns) {
+    uint64_t c = checksumBytes(ref, packedWords(h.refLen) * sizeof(uint64_t));
+    c = checksumBytes(sa, posArrayBytes(h.saLen), c);
+    c = checksumBytes(lcp, h.lcpLen * sizeof(int), c);
+    c = checksumBytes(kmer, posArrayBytes(h.kmerLen), c);
+    c = checksumBytes(llcp, h.lcplrLen * sizeof(int), c);
+    c = checksumBytes(rlcp, h.lcplrLen * sizeof(int), c);
+    for (int p = 0; p < SPACED_SEED_COUNT; ++p) c = checksumBytes(spaced[p], posArrayBytes(h.spacedLen[p]), c);
+    c = checksumBytes(fm.blocks, fmBlockCount(h.fmRows) * sizeof(OccBlock), c);
+    c = checksumBytes(fm.marks, fmMarkWords(h.fmRows) * sizeof(uint64_t), c);
+    c = checksumBytes(fm.markRank, fmMarkWords(h.fmRows) * sizeof(RowCount), c);
+    c = checksumBytes(fm.samples.ptr, posArrayBytes(h.fmSamplesLen), c);
+    c = checksumBytes(contigBlob.data(), contigBlob.size(), c);
+    c = checksumBytes(nRuns, h.nRunCount * sizeof(NRun), c);
+    return c;
+}
+
+// 인덱스를 파일로 저장
+bool saveIndex(const SAIndex& idx, const string& file) {
+    IndexHeader h{};
+    memcpy(h.magic, INDEX_MAGIC, sizeof(h.magic));
+    h.version = INDEX_VERSION;
+    h.headerSize = sizeof(IndexHeader);
+    h.refLen = idx.reference.size();
+    h.saLen = idx.backend == IndexBackend::SA ? idx.sa.size() : 0;
+    h.lcpLen = idx.backend == IndexBackend::SA ? idx.lcp.size() : 0;
+    h.seedLen = SEED_LEN;
+    h.maxError = MAX_ERROR;
+    h.refOffset = alignUp(sizeof(IndexHeader), INDEX_ALIGN);
+    h.saOffset = alignUp(h.refOffset + packedWords(h.refLen) * sizeof(uint64_t), INDEX_ALIGN);
+    h.lcpOffset = alignUp(h.saOffset + posArrayBytes(h.saLen), INDEX_ALIGN);
+    h.kmerK = idx.kmerK;
+    h.posBytes = POS_BYTES;
+    h.kmerLen = idx.kmerStart.size();
+    h.kmerOffset = alignUp(h.lcpOffset + h.lcpLen * sizeof(int), INDEX_ALIGN);
+    h.lcplrLen = idx.llcp.size();
+    h.llcpOffset = alignUp(h.kmerOffset + posArrayBytes(h.kmerLen), INDEX_ALIGN);
+    h.rlcpOffset = alignUp(h.llcpOffset + h.lcplrLen * sizeof(int), INDEX_ALIGN);
+    uint64_t end = h.rlcpOffset + h.lcplrLen * sizeof(int);
+    const char* spaced[SPACED_SEED_COUNT];
+    for (int p = 0; p < SPACED_SEED_COUNT; ++p) {
+        strncpy(h.spacedPattern[p], SPACED_SEED_PATTERNS[p], sizeof(h.spacedPattern[p]));
+        h.spacedLen[p] = idx.spaced[p].size();
+        h.spacedOffset[p] = alignUp(end, INDEX_ALIGN);
+        end = h.spacedOffset[p] + posArrayBytes(h.spacedLen[p]);
+        spaced[p] = idx.spaced[p].ptr;
+    }
+    const FMIndex& fm = idx.fm;
+    h.backend = (uint32_t)idx.backend;
+    h.fmSampleRate = FM_SA_SAMPLE;
+    h.fmRows = idx.backend == IndexBackend::FM ? fm.rows : 0;
+    h.fmDollarRow = fm.dollarRow;
+    memcpy(h.fmC, fm.C, sizeof(h.fmC));
+    h.fmBlockOffset = alignUp(end, INDEX_ALIGN);
+    h.fmMarkOffset = alignUp(h.fmBlockOffset + fmBlockCount(h.fmRows) * sizeof(OccBlock), INDEX_ALIGN);
+    h.fmRankOffset = alignUp(h.fmMarkOffset + fmMarkWords(h.fmRows) * sizeof(uint64_t), INDEX_ALIGN);
+    h.fmSamplesLen = fm.samples.size();
+    h.fmSamplesOffset = alignUp(h.fmRankOffset + fmMarkWords(h.fmRows) * sizeof(RowCount), INDEX_ALIGN);
+    string contigBlob = serializeContigs(idx.layout);
+    h.contigCount = idx.layout.contigs.size();
+    h.contigBytes = contigBlob.size();
+    h.contigOffset = alignUp(h.fmSamplesOffset + posArrayBytes(h.fmSamplesLen), INDEX_ALIGN);
+    h.nRunCount = idx.layout.nRuns.size();
+    h.nRunOffset = alignUp(h.contigOffset + h.contigBytes, INDEX_ALIGN);
+    h.fileSize = h.nRunOffset + h.nRunCount * sizeof(NRun);
+
+    h.checksum = indexChecksum(h, idx.reference.words, idx.sa.ptr, idx.lcp.ptr, idx.kmerStart.ptr, idx.llcp.ptr, idx.rlcp.ptr,
+                               spaced, fm, contigBlob, idx.layout.nRuns.data());
+
+    ofstream fout(file, ios::binary);
+    if (!fout) {
+        cerr << "인덱스 파일을 열 수 없음: " << file << "\n";
+        return false;
+    }
+    auto padTo = [&](uint64_t off) {
+        static const char zeros[INDEX_ALIGN] = {};
+        uint64_t cur = fout.tellp();
+        fout.write(zeros, off - cur);
+    };
+    fout.write((const char*)&h, sizeof(h));
+    padTo(h.refOffset);
+    fout.write((const char*)idx.reference.words, packedWords(h.refLen) * sizeof(uint64_t));
+    padTo(h.saOffset);
+    fout.write(idx.sa.ptr, posArrayBytes(h.saLen));
+    padTo(h.lcpOffset);
+    fout.write((const char*)idx.lcp.ptr, h.lcpLen * sizeof(int));
+    padTo(h.kmerOffset);
+    fout.write(idx.kmerStart.ptr, posArrayBytes(h.kmerLen));
+    padTo(h.llcpOffset);
+    fout.write((const char*)idx.llcp.ptr, h.lcplrLen * sizeof(int));
+    padTo(h.rlcpOffset);
+    fout.write((const char*)idx.rlcp.ptr, h.lcplrLen * sizeof(int));
+    for (int p = 0; p < SPACED_SEED_COUNT; ++p) {
+        padTo(h.spacedOffset[p]);
+        fout.write(spaced[p], posArrayBytes(h.spacedLen[p]));
+    }
+    padTo(h.fmBlockOffset);
+    fout.write((const char*)fm.blocks, fmBlockCount(h.fmRows) * sizeof(OccBlock));
+    padTo(h.fmMarkOffset);
+    fout.write((const char*)fm.marks, fmMarkWords(h.fmRows) * sizeof(uint64_t));
+    padTo(h.fmRankOffset);
+    fout.write((const char*)fm.markRank, fmMarkWords(h.fmRows) * sizeof(RowCount));
+    padTo(h.fmSamplesOffset);
+    fout.write(fm.samples.ptr, posArrayBytes(h.fmSamplesLen));
+    padTo(h.contigOffset);
+    fout.write(contigBlob.data(), contigBlob.size());
+    padTo(h.nRunOffset);
+    fout.write((const char*)idx.layout.nRuns.data(), h.nRunCount * sizeof(NRun));
+    padTo(h.fileSize);
+    if (!fout) {
+        cerr << "인덱스 파일 쓰기 실패: " << file << "\n";
+        return false;
+    }
+    return true;
+}
+
+// 인덱스 파일을 mmap으로 불러옴 (여러 프로세스가 page cache를 공유)
+// 헤더와 파일 크기만 확인하므로 게놈 크기와 무관하게 즉시 로드됨, verify=true면 체크섬까지 검사
+bool loadIndex(SAIndex& idx, const string& file, bool verify) {
+    int fd = open(file.c_str(), O_RDONLY);
+    if (fd < 0) {
+        cerr << "인덱스 파일을 열 수 없음: " << file << "\n";
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(IndexHeader)) {
+        cerr << "잘못된 인덱스 파일: " << file << "\n";
+        close(fd);
+        return false;
+    }
+    void* addr = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (addr == MAP_FAILED) {
+        cerr << "mmap 실패: " << file << "\n";
+        return false;
+    }
+    idx.mapAddr = addr;
+    idx.mapSize = st.st_size;
+
+    const char* base = (const char*)addr;
+    IndexHeader h;
+    memcpy(&h, base, sizeof(h));
+    if (memcmp(h.magic, INDEX_MAGIC, sizeof(h.magic)) != 0) {
+        cerr << "인덱스 파일 형식이 아님: " << file << "\n";
+        return false;
+    }
+    if (h.version != INDEX_VERSION || h.headerSize != sizeof(IndexHeader)) {
+        cerr << "지원하지 않는 인덱스 버전: " << h.version << " (필요: " << INDEX_VERSION << ")\n";
+        return false;
+    }
+    if (h.posBytes != (uint32_t)POS_BYTES) {
+        cerr << "인덱스의 위치 크기(" << h.posBytes << "바이트)가 현재 빌드(" << POS_BYTES << "바이트)와 다름, "
+             << (h.posBytes == 5 ? "-DALIGNER_POS40으로 다시 컴파일" : "-DALIGNER_POS40 없이 다시 컴파일") << "하거나 인덱스를 다시 구축해야 함\n";
+        return false;
+    }
+    bool fmBackend = h.backend == (uint32_t)IndexBackend::FM;
+    bool sizesOk = fmBackend ? h.saLen == 0 && h.lcpLen == 0 && h.kmerLen == 0 && h.lcplrLen == 0 &&
+                                   h.fmRows == h.refLen + 1 && h.fmSampleRate == (uint32_t)FM_SA_SAMPLE &&
+                                   h.fmSamplesLen == h.refLen / FM_SA_SAMPLE + 1 && h.fmDollarRow < h.fmRows && h.fmC[0] == 1 &&
+                                   h.fmC[0] <= h.fmC[1] && h.fmC[1] <= h.fmC[2] && h.fmC[2] <= h.fmC[3] && h.fmC[3] <= h.fmRows
+                             : h.backend == (uint32_t)IndexBackend::SA && h.saLen == h.refLen && h.lcpLen == h.refLen &&
+                                   h.fmRows == 0 &&
+                                   h.kmerK <= 15 && (h.kmerK == 0 || h.kmerLen == ((uint64_t)1 << (2 * h.kmerK)) + 1) &&
+                                   (h.lcplrLen == 0 || h.lcplrLen == h.refLen);
+    // 모든 구역이 파일 안에 있어야 함 (헤더가 잘리거나 깨진 경우 뷰를 만들기 전에 거름, 곱셈 오버플로 없이 나눗셈으로 비교)
+    auto inFile = [&](uint64_t off, uint64_t n, uint64_t elem) { return off <= h.fileSize && n <= (h.fileSize - off) / elem; };
+    auto posInFile = [&](uint64_t off, uint64_t n) { return inFile(off, n, POS_BYTES) && posArrayBytes(n) <= h.fileSize - off; };
+    sizesOk = sizesOk && inFile(h.refOffset, h.refLen / 4, 1) && inFile(h.refOffset, packedWords(h.refLen), sizeof(uint64_t)) &&
+              posInFile(h.saOffset, h.saLen) && inFile(h.lcpOffset, h.lcpLen, sizeof(int)) && posInFile(h.kmerOffset, h.kmerLen) &&
+              inFile(h.llcpOffset, h.lcplrLen, sizeof(int)) && inFile(h.rlcpOffset, h.lcplrLen, sizeof(int)) &&
+              inFile(h.fmBlockOffset, fmBlockCount(h.fmRows), sizeof(OccBlock)) &&
+              inFile(h.fmMarkOffset, fmMarkWords(h.fmRows), sizeof(uint64_t)) &&
+              inFile(h.fmRankOffset, fmMarkWords(h.fmRows), sizeof(RowCount)) && posInFile(h.fmSamplesOffset, h.fmSamplesLen) &&
+              inFile(h.contigOffset, h.contigBytes, 1) && inFile(h.nRunOffset, h.nRunCount, sizeof(NRun));
+    for (int p = 0; p < SPACED_SEED_COUNT; ++p) sizesOk = sizesOk && posInFile(h.spacedOffset[p], h.spacedLen[p]);
+    if (h.fileSize != (uint64_t)st.st_size || !sizesOk) {
+        cerr << "인덱스 파일이 손상됨 (길이 불일치): " << file << "\n";
+        return false;
+    }
+    for (int p = 0; p < SPACED_SEED_COUNT; ++p) {
+        if (h.spacedLen[p] > h.refLen) {
+            cerr << "인덱스 파일이 손상됨 (길이 불일치): " << file << "\n";
+            return false;
+        }
+        if (h.spacedLen[p] > 0 && strncmp(h.spacedPattern[p], SPACED_SEED_PATTERNS[p], sizeof(h.spacedPattern[p])) != 0) {
+            cerr << "인덱스의 spaced seed 패턴(" << string(h.spacedPattern[p], strnlen(h.spacedPattern[p], 8))
+                 << ")이 현재 컴파일된 패턴과 다름, 인덱스를 다시 구축해야 함\n";
+            return false;
+        }
+    }
+    if (h.seedLen != (uint32_t)SEED_LEN || h.maxError != (uint32_t)MAX_ERROR)
+        cerr << "경고: 인덱스 구축 시 파라미터(SEED_LEN=" << h.seedLen << ", MAX_ERROR=" << h.maxError
+             << ")가 현재 값과 다름\n";
+
+    const uint64_t* ref = (const uint64_t*)(base + h.refOffset);
+    const char* sa = base + h.saOffset;
+    const int* lcp = (const int*)(base + h.lcpOffset);
+    const char* kmer = h.kmerLen > 0 ? base + h.kmerOffset : nullptr;
+    const int* llcp = h.lcplrLen > 0 ? (const int*)(base + h.llcpOffset) : nullptr;
+    const int* rlcp = h.lcplrLen > 0 ? (const int*)(base + h.rlcpOffset) : nullptr;
+    const char* spaced[SPACED_SEED_COUNT];
+    for (int p = 0; p < SPACED_SEED_COUNT; ++p)
+        spaced[p] = h.spacedLen[p] > 0 ? base + h.spacedOffset[p] : nullptr;
+    FMIndex fm;
+    if (fmBackend) {
+        fm.blocks = (const OccBlock*)(base + h.fmBlockOffset);
+        fm.rows = h.fmRows;
+        fm.dollarRow = h.fmDollarRow;
+        memcpy(fm.C, h.fmC, sizeof(fm.C));
+        fm.marks = (const uint64_t*)(base + h.fmMarkOffset);
+        fm.markRank = (const RowCount*)(base + h.fmRankOffset);
+        fm.samples = PosView(base + h.fmSamplesOffset, h.fmSamplesLen);
+        // C 표가 BWT의 염기 수와 맞아야 LF 이동이 행 범위를 벗어나지 않음 (마지막 occ 블록만 읽음)
+        for (int c = 0; c < 4; ++c)
+            if (fm.C[c] + fm.occ(c, fm.rows) != (c < 3 ? fm.C[c + 1] : fm.rows)) {
+                cerr << "인덱스 파일이 손상됨 (FM-index C 표): " << file << "\n";
+                return false;
+            }
+    }
+    string_view contigBlob(base + h.contigOffset, h.contigBytes);
+    const NRun* nRuns = (const NRun*)(base + h.nRunOffset);
+    if (verify && indexChecksum(h, ref, sa, lcp, kmer, llcp, rlcp, spaced, fm, contigBlob, nRuns) != h.checksum) {
+        cerr << "인덱스 체크섬 불일치: " << file << "\n";
+        return false;
+    }
+    if (!parseContigs(contigBlob, h.contigCount, idx.layout)) {
+        cerr << "인덱스 파일이 손상됨 (contig 표): " << file << "\n";
+        return false;
+    }
+    idx.layout.nRuns.assign(nRuns, nRuns + h.nRunCount);
+
+    // SA 이진 탐색과 FM backward search는 임의 접근이므로 커널의 순차 readahead를 끔
+    // (파일 매핑에는 THP가 붙지 않으므로 huge page는 --huge-pages로 익명 메모리에 복사해서 씀, placeIndex 참고)
+    madvise((void*)(base + h.saOffset), h.fileSize - h.saOffset, MADV_RANDOM);
+
+    idx.backend = fmBackend ? IndexBackend::FM : IndexBackend::SA;
+    idx.fm = fm;
+    idx.reference = PackedRef(ref, h.refLen);
+    idx.sa = PosView(sa, h.saLen);
+    idx.lcp = IntView(lcp, h.lcpLen);
+    idx.kmerK = h.kmerK;
+    idx.kmerStart = PosView(kmer, h.kmerLen);
+    idx.llcp = IntView(llcp, h.lcplrLen);
+    idx.rlcp = IntView(rlcp, h.lcplrLen);
+    for (int p = 0; p < SPACED_SEED_COUNT; ++p) idx.spaced[p] = PosView(spaced[p], h.spacedLen[p]);
+    return true;
+}
+
+// ✅ 인덱스 배치 (huge page, NUMA 노드별 복제본)
+// 읽기 전용 배열들을 익명 메모리 영역 하나로 복사해 두고 뷰를 그쪽으로 돌림
+// 큰 SA를 임의 접근하면 4KB 페이지로는 TLB가 모자라므로 2MB/1GB 페이지를 쓰고,
+// 여러 소켓 호스트에서는 노드마다 복제본을 두어 스레드가 자기 노드 메모리만 읽게 함
+enum class HugePageMode { Off, Huge2M, Huge1G };
+
+const size_t HUGE_PAGE_2M = 1 << 21, HUGE_PAGE_1G = 1 << 30;
+
+// 익명 메모리 할당: hugetlb 1GB(Huge1G만) → hugetlb 2MB → 일반 페이지 + MADV_HUGEPAGE(THP) 순으로 시도
+// node >= 0이면 첫 접근 전에 mbind로 그 NUMA 노드에 고정 (hugetlb는 전역 예약이라 노드에 여유 페이지가 있어야 함)
+// mapped: 실제 매핑 크기 (munmap용), backing: 실제로 얻은 페이지 종류
+void* allocIndexMemory(size_t bytes, HugePageMode mode, int node, size_t& mapped, string& backing) {
+    void* p = MAP_FAILED;
+    auto tryHugetlb = [&](size_t page, int shift, const char* name) {
+        mapped = alignUp(bytes, page);
+        p = mmap(nullptr, mapped, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | (shift << MAP_HUGE_SHIFT), -1, 0);
+        if (p != MAP_FAILED) backing = name;
+    };
+    if (mode == HugePageMode::Huge1G) tryHugetlb(HUGE_PAGE_1G, 30, "hugetlb 1GB");
+    if (p == MAP_FAILED && mode != HugePageMode::Off) tryHugetlb(HUGE_PAGE_2M, 21, "hugetlb 2MB");
+    if (p == MAP_FAILED) {
+        mapped = alignUp(bytes, mode == HugePageMode::Off ? 4096 : HUGE_PAGE_2M);
+        p = mmap(nullptr, mapped, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (p == MAP_FAILED) return nullptr;
+        backing = "4KB 페이지";
+        if (mode != HugePageMode::Off && madvise(p, mapped, MADV_HUGEPAGE) == 0) backing = "THP (madvise)";
+    }
+    if (node >= 0 && node < 64) {
+        unsigned long mask = 1UL << node;
+        if (syscall(SYS_mbind, p, mapped, MPOL_BIND, &mask, 64, 0) != 0) backing += ", mbind 실패";
+    }
+    return p;
+}
+
+// 매핑 안에서 실제로 huge page로 잡힌 바이트 수 (/proc/self/smaps의 AnonHugePages + hugetlb)
+size_t hugePageBytes(const void* addr) {
+    ifstream fin("/proc/self/smaps");
+    string line;
+    bool inside = false;
+    size_t bytes = 0;
+    uintptr_t a = (uintptr_t)addr;
+    while (getline(fin, line)) {
+        unsigned long lo, hi;
+        if (sscanf(line.c_str(), "%lx-%lx ", &lo, &hi) == 2 && line.find(':') > line.find(' ')) {
+            if (inside) break;
+            inside = lo <= a && a < hi;
+            continue;
+        }
+        size_t kb;
+        if (inside && (sscanf(line.c_str(), "AnonHugePages: %zu kB", &kb) == 1 ||
+                       sscanf(line.c_str(), "Private_Hugetlb: %zu kB", &kb) == 1))
+            bytes += kb << 10;
+    }
+    return bytes;
+}
+
+// src의 읽기 전용 배열(reference, SA, LCP, k-mer 테이블, LCP-LR, spaced seed, FM-index)을 새 영역 하나로 복사하고
+// dst의 뷰를 그쪽으로 돌림, 배열마다 2MB 경계에서 시작해 huge page 하나가 두 배열에 걸치지 않게 함
+// dst == src면 제자리 배치: 복사가 끝난 뒤 원래 저장소(vector 또는 인덱스 파일 mmap)를 해제 (복사 중에는 두 벌이 필요)
+bool placeIndex(const SAIndex& src, SAIndex& dst, HugePageMode mode, int node, string& backing) {
+    const FMIndex& fm = src.fm;
+    uint64_t fmRows = src.backend == IndexBackend::FM ? fm.rows : 0;
+    const void* from[] = {src.reference.words, src.sa.ptr, src.lcp.ptr, src.kmerStart.ptr, src.llcp.ptr, src.rlcp.ptr,
+                          fm.blocks, fm.marks, fm.markRank, fm.samples.ptr};
+    size_t bytes[] = {packedWords(src.reference.size()) * sizeof(uint64_t), posArrayBytes(src.sa.size()),
+                      src.lcp.size() * sizeof(int), posArrayBytes(src.kmerStart.size()), src.llcp.size() * sizeof(int),
+                      src.rlcp.size() * sizeof(int), fmRows ? fmBlockCount(fmRows) * sizeof(OccBlock) : 0,
+                      fmRows ? fmMarkWords(fmRows) * sizeof(uint64_t) : 0, fmRows ? fmMarkWords(fmRows) * sizeof(RowCount) : 0,
+                      posArrayBytes(fm.samples.size())};
+    const int fixed = sizeof(bytes) / sizeof(bytes[0]), sections = fixed + SPACED_SEED_COUNT;
+    vector<const void*> srcPtr(from, from + fixed);
+    vector<size_t> size(bytes, bytes + fixed), offset(sections);
+    for (int p = 0; p < SPACED_SEED_COUNT; ++p) {
+        srcPtr.push_back(src.spaced[p].ptr);
+        size.push_back(posArrayBytes(src.spaced[p].size()));
+    }
+    size_t total = 0;
+    for (int k = 0; k < sections; ++k) {
+        offset[k] = total;
+        total = alignUp(total + size[k], HUGE_PAGE_2M);
+    }
+
+    size_t mapped = 0;
+    char* region = (char*)allocIndexMemory(max<size_t>(total, 1), mode, node, mapped, backing);
+    if (!region) return false;
+    // 인덱스 파일은 평소 MADV_RANDOM이므로 복사하는 동안만 순차 readahead를 켬
+    if (src.mapAddr) madvise(src.mapAddr, src.mapSize, MADV_SEQUENTIAL);
+    for (int k = 0; k < sections; ++k)
+        if (size[k]) memcpy(region + offset[k], srcPtr[k], size[k]);
+    auto at = [&](int k) -> const char* { return size[k] ? region + offset[k] : nullptr; };
+
+    if (&dst == &src) {
+        vector<uint64_t>().swap(dst.refStorage);
+        PosStorage().swap(dst.saStorage);
+        PosStorage().swap(dst.kmerStorage);
+        vector<int>().swap(dst.lcpStorage);
+        vector<int>().swap(dst.llcpStorage);
+        vector<int>().swap(dst.rlcpStorage);
+        for (auto& s : dst.spacedStorage) PosStorage().swap(s);
+        dst.fmStorage = FMStorage();
+        if (dst.mapAddr) munmap(dst.mapAddr, dst.mapSize);
+    } else {
+        if (src.mapAddr) madvise(src.mapAddr, src.mapSize, MADV_RANDOM);
+        dst.backend = src.backend;
+        dst.layout = src.layout;
+        dst.kmerK = src.kmerK;
+        dst.fm = src.fm;
+        if (dst.mapAddr) munmap(dst.mapAddr, dst.mapSize);
+    }
+    dst.mapAddr = region;
+    dst.mapSize = mapped;
+    dst.reference = PackedRef((const uint64_t*)at(0), src.reference.size());
+    dst.sa = PosView(at(1), src.sa.size());
+    dst.lcp = IntView((const int*)at(2), src.lcp.size());
+    dst.kmerStart = PosView(at(3), src.kmerStart.size());
+    dst.llcp = IntView((const int*)at(4), src.llcp.size());
+    dst.rlcp = IntView((const int*)at(5), src.rlcp.size());
+    if (fmRows) {
+        dst.fm.blocks = (const OccBlock*)at(6);
+        dst.fm.marks = (const uint64_t*)at(7);
+        dst.fm.markRank = (const RowCount*)at(8);
+    }
+    dst.fm.samples = PosView(at(9), src.fm.samples.size());
+    for (int p = 0; p < SPACED_SEED_COUNT; ++p) dst.spaced[p] = PosView(at(fixed + p), src.spaced[p].size());
+    mprotect(region, mapped, PROT_READ);  // 복제본끼리 실수로 어긋나지 않도록 읽기 전용으로
+    return true;
+}
+
+// 쉼표/구간 형식 CPU 목록 파싱 (예: "0-3,8-11")
+vector<int> parseCpuList(const string& list) {
+    vector<int> cpus;
+    stringstream ss(list);
+    string part;
+    while (getline(ss, part, ',')) {
+        int lo, hi;
+        int n = sscanf(part.c_str(), "%d-%d", &lo, &hi);
+        if (n == 1) hi = lo;
+        if (n >= 1)
+            for (int c = lo; c <= hi; ++c) cpus.push_back(c);
+    }
+    return cpus;
+}
+
+// CPU가 있는 NUMA 노드별 (노드 번호, CPU 목록) (/sys/devices/system/node)
+// CPU 없는 메모리 전용 노드(CXL, HBM 등)는 뺌. 정보가 없으면 노드 번호 -1 (mbind 안 함) 하나에 모든 CPU
+vector<pair<int, vector<int>>> numaNodeCpus() {
+    vector<pair<int, vector<int>>> nodes;
+    ifstream online("/sys/devices/system/node/online");
+    string list;
+    if (getline(online, list)) {
+        for (int node : parseCpuList(list)) {
+            ifstream fin("/sys/devices/system/node/node" + to_string(node) + "/cpulist");
+            string cpus;
+            if (!getline(fin, cpus)) continue;
+            vector<int> c = parseCpuList(cpus);
+            if (!c.empty()) nodes.emplace_back(node, move(c));
+        }
+    }
+    if (nodes.empty()) {
+        nodes.emplace_back(-1, vector<int>());
+        for (unsigned c = 0; c < max(1u, thread::hardware_concurrency()); ++c) nodes[0].second.push_back(c);
+    }
+    return nodes;
+}
+
+// NUMA 노드마다 인덱스 복제본 하나: t번 정렬 스레드는 노드 t % 노드 수의 CPU에 고정되어 그 노드의 복제본만 읽음
+// 복제본 메모리는 mbind로 그 CPU들이 속한 노드에 둠
+struct IndexReplicas {
+    vector<int> nodeIds;
+    vector<vector<int>> cpus;
+    vector<unique_ptr<SAIndex>> nodes;
+
+    // 현재 스레드를 t번 스레드의 노드에 고정하고 그 노드의 복제본 반환
+    const SAIndex& bind(int t) const {
+        int n = t % nodes.size();
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        for (int c : cpus[n]) CPU_SET(c, &set);
+        sched_setaffinity(0, sizeof(set), &set);
+        return *nodes[n];
+    }
+};
+
+// 노드마다 복제본을 만듦 (복제본을 채우는 동안 현재 스레드도 그 노드에 고정)
+bool buildReplicas(const SAIndex& idx, HugePageMode mode, IndexReplicas& out) {
+    vector<pair<int, vector<int>>> topo = numaNodeCpus();
+    cpu_set_t saved;
+    sched_getaffinity(0, sizeof(saved), &saved);
+    for (size_t n = 0; n < topo.size(); ++n) {
+        int id = topo[n].first;
+        out.nodeIds.push_back(id);
+        out.cpus.push_back(topo[n].second);
+        out.nodes.push_back(make_unique<SAIndex>());
+        out.bind(n);
+        string backing;
+        if (!placeIndex(idx, *out.nodes.back(), mode, id, backing)) {
+            sched_setaffinity(0, sizeof(saved), &saved);
+            return false;
+        }
+        const SAIndex& r = *out.nodes.back();
+        cout << "  노드 " << id << " 복제본: CPU " << topo[n].second.size() << "개, " << r.mapSize / 1048576.0 << " MB (" << backing
+             << ", huge page " << (hugePageBytes(r.mapAddr) >> 20) << " MB)\n";
+    }
+    sched_setaffinity(0, sizeof(saved), &saved);
+    return true;
+}
+
+class ReadCache;
+
+// 정렬 옵션
+// 결과 출력 형식: 텍스트 한 줄, 고정 크기 binary 레코드 (하위 도구용), 최소 SAM
+enum class OutputFormat { Text, Binary, SAM };
+
+struct AlignOptions {
+    MismatchKernel countMismatch = countMismatchScalar;
+    bool multiSeed = false;    // read 전체를 겹치지 않는 시드들로 나눠 검색 (pigeonhole)
+    int maxSeedHits = 500;     // 시드 하나당 사용할 최대 후보 수 (반복 영역 대비)
+    int spacedSeeds = 0;       // 활성 spaced seed 패턴 비트마스크 (SPACED_SEED_PATTERNS 순서)
+    int searchBatch = 16;      // 첫 시드를 묶음 이진 탐색으로 함께 찾을 read 수 (1이면 read마다 따로)
+    bool bothStrands = true;   // 역방향 가닥(역상보)도 검색
+    bool editDistance = false; // Hamming으로 못 맞춘 read를 밴드 편집 거리로 재검증 (indel 허용)
+    int maxCandidates = 256;   // 단일 접두사 경로에서 첫 시드 구간당 검증할 최대 후보 수 (반복 영역 대비)
+    ReadCache* cache = nullptr; // 같은 서열 read의 결과 캐시 (스레드 공유, 없으면 사용 안 함)
+    OutputFormat format = OutputFormat::Text;
+    const IndexReplicas* replicas = nullptr; // NUMA 노드별 인덱스 복제본 (없으면 모든 스레드가 같은 인덱스 사용)
+    bool sortSeeds = false;    // 묶음 이진 탐색 전에 read 묶음을 첫 시드 코드로 정렬 (alignBlockSorted)
+};
+
+// t번 정렬 스레드가 읽을 인덱스: 복제본이 있으면 스레드를 그 노드에 고정하고 노드의 복제본을, 없으면 idx 그대로
+// 소멸 시 스레드의 원래 CPU 고정을 복원 (OpenMP 스레드는 정렬 뒤에도 재사용되므로)
+class LocalIndex {
+    const SAIndex* local;
+    cpu_set_t saved;
+    bool pinned = false;
+
+public:
+    LocalIndex(const SAIndex& idx, const AlignOptions& opt, int t) : local(&idx) {
+        if (!opt.replicas) return;
+        pinned = sched_getaffinity(0, sizeof(saved), &saved) == 0;
+        local = &opt.replicas->bind(t);
+    }
+    ~LocalIndex() {
+        if (pinned) sched_setaffinity(0, sizeof(saved), &saved);
+    }
+    LocalIndex(const LocalIndex&) = delete;
+    LocalIndex& operator=(const LocalIndex&) = delete;
+    const SAIndex& get() const { return *local; }
+};
+
+// read 하나의 정렬 결과
+struct AlignResult {
+    Pos pos = -1;
+    int mismatch = MAX_ERROR + 1;
+    bool prefixHit = false;    // 첫 시드(기존 단일 접두사 경로)의 후보만으로도 매칭되는지
+    bool reverse = false;      // 역방향 가닥(역상보)에서 매칭됨
+    string cigar;              // 편집 거리 모드에서만 기록
+    bool edited = false;       // 편집 거리 검증으로 Hamming 결과보다 나아짐
+    int second = MAX_ERROR + 1; // 다른 위치 중 가장 적은 mismatch (best와 같으면 multi-mapped)
+    bool truncated = false;    // 후보 상한에 걸려 검증하지 못한 후보가 남음
+    int mapq = 0;              // finishRead에서 계산
+};
+
+// mapping quality: best와 second의 차이 1당 MAPQ_PER_MISMATCH (최대 MAPQ_MAX), 같으면 0
+// 후보 상한에 걸린 read는 검증하지 않은 후보 중에 더 나은 위치가 있을 수 있으므로 MAPQ_TRUNCATED 이하로 제한
+const int MAPQ_PER_MISMATCH = 10, MAPQ_MAX = 60, MAPQ_TRUNCATED = 3;
+
+int mappingQuality(const AlignResult& res) {
+    if (res.second <= res.mismatch) return 0;
+    int q = min(MAPQ_MAX, MAPQ_PER_MISMATCH * (res.second - res.mismatch));
+    return res.truncated ? min(q, MAPQ_TRUNCATED) : q;
+}
+
+// second가 best보다 이만큼 이상 크면 MAPQ는 상한으로 같음 (MAPQ_MAX면 6, 후보 상한에 걸려 MAPQ_TRUNCATED면 1)
+inline int mapqSaturationGap(bool truncated) {
+    return ((truncated ? MAPQ_TRUNCATED : MAPQ_MAX) + MAPQ_PER_MISMATCH - 1) / MAPQ_PER_MISMATCH;
+}
+
+// 후보 검증에 쓸 mismatch 상한: best 이하인 값은 정확히 세야 best(와 같은 값의 위치 기준)를 갱신할 수 있고,
+// second는 MAPQ를 바꿀 수 있는 값(best + 포화 간격 미만)까지만 세면 됨
+// → best가 0이면 상한이 5로 내려가 그보다 나쁜 후보는 커널이 그 자리에서 멈춤 (second는 포화 값으로 기록되어 MAPQ는 같음)
+inline int candidateLimit(const AlignResult& res) {
+    int second = min(res.second, res.mismatch + mapqSaturationGap(res.truncated));
+    return min(MAX_ERROR, max(second - 1, res.mismatch));
+}
+
+// 후보 하나의 mismatch를 best/second에 반영 (같은 mismatch면 먼저 본 후보를 유지, preferOnTie면 이 후보로 교체)
+// 더 볼 필요가 없으면 true: 서로 다른 두 위치에서 mismatch 0 → 결과(위치 기준 포함)와 MAPQ 0이 바뀔 수 없음
+inline bool updateBest(AlignResult& res, Pos pos, int mismatch, bool preferOnTie = false) {
+    if (mismatch < res.mismatch || (preferOnTie && mismatch == res.mismatch)) {
+        res.second = res.mismatch;
+        res.mismatch = mismatch;
+        res.pos = pos;
+    } else if (mismatch < res.second) {
+        res.second = mismatch;
+    }
+    return res.second == 0;
+}
+
+// read 캐시 키: 2비트 압축 서열 (ACGT만으로 된 READ_CACHE_MAX_LEN 이하 read만 캐시)
+const int READ_CACHE_MAX_LEN = 128;
+
+struct CacheKey {
+    uint64_t words[READ_CACHE_MAX_LEN / 32] = {};
+    uint32_t len = 0;  // 0이면 캐시할 수 없는 read
+
+    bool operator==(const CacheKey& o) const { return len == o.len && memcmp(words, o.words, sizeof(words)) == 0; }
+};
+
+struct CacheKeyHash {
+    size_t operator()(const CacheKey& k) const {
+        uint64_t h = k.len;
+        for (uint64_t w : k.words) {
+            h = (h ^ w) * 0x9E3779B97F4A7C15ULL;
+            h ^= h >> 29;
+        }
+        return h;
+    }
+};
+
+// 같은 서열 read의 정렬 결과 캐시 (결과는 read 서열만으로 정해지므로 복사해 써도 출력이 같음)
+// 메모리 예산으로 정한 고정 크기 표를 WAYS개 항목씩 묶음(set)으로 나눈 set-associative 구조: 키 해시로 set을 고르고,
+// set이 가득 차면 가장 오래 쓰지 않은 항목을 교체 (LRU). set들은 SHARDS개 잠금에 나눠 걸어 스레드 간 경합을 줄임
+// set마다 해시 태그와 사용 순번을 캐시 라인 하나에 모아 두어, 없는 read는 그 한 줄만 읽고 끝남
+// 조회와 삽입에 할당이 없음 (편집 거리 모드의 CIGAR 문자열 복사 제외)
+class ReadCache {
+    static constexpr int WAYS = 4, SHARDS = 64;
+
+    struct alignas(32) SetMeta {
+        uint32_t tag[WAYS] = {};      // 해시 하위 32비트 | 1 (0이면 빈 항목)
+        uint32_t lastUse[WAYS] = {};  // LRU용 사용 순번
+    };
+
+    struct Entry {
+        CacheKey key;
+        AlignResult res;
+    };
+
+    struct alignas(64) Shard {
+        mutex m;
+        uint32_t clock = 0;
+        uint64_t evictions = 0;
+    };
+
+    vector<SetMeta> meta;
+    vector<Entry> entries;
+    size_t sets;
+    Shard shards[SHARDS];
+
+    size_t setOf(size_t h) const { return (h >> 32) % sets; }
+    static uint32_t tagOf(size_t h) { return uint32_t(h) | 1; }
+
+public:
+    explicit ReadCache(size_t bytes) : sets(max<size_t>(1, bytes / (sizeof(SetMeta) + sizeof(Entry) * WAYS))) {
+        meta.resize(sets);
+        entries.resize(sets * WAYS);
+    }
+
+    // read를 키로 압축 (캐시할 수 없으면 false)
+    static bool makeKey(string_view read, CacheKey& key) {
+        key = CacheKey();
+        if (read.empty() || read.size() > READ_CACHE_MAX_LEN) return false;
+        for (size_t i = 0; i < read.size(); ++i) {
+            int c = baseCode(read[i]);
+            if (c < 0) return false;
+            key.words[i >> 5] |= (uint64_t)c << (62 - 2 * (i & 31));
+        }
+        key.len = read.size();
+        return true;
+    }
+
+    bool find(const CacheKey& key, AlignResult& res) {
+        size_t h = CacheKeyHash()(key), set = setOf(h);
+        uint32_t tag = tagOf(h);
+        SetMeta& m = meta[set];
+        Shard& sh = shards[set % SHARDS];
+        lock_guard<mutex> lk(sh.m);
+        for (int w = 0; w < WAYS; ++w) {
+            if (m.tag[w] != tag) continue;
+            Entry& e = entries[set * WAYS + w];
+            if (!(e.key == key)) continue;
+            m.lastUse[w] = ++sh.clock;
+            res = e.res;
+            return true;
+        }
+        return false;
+    }
+
+    void insert(const CacheKey& key, const AlignResult& res) {
+        size_t h = CacheKeyHash()(key), set = setOf(h);
+        uint32_t tag = tagOf(h);
+        SetMeta& m = meta[set];
+        Shard& sh = shards[set % SHARDS];
+        lock_guard<mutex> lk(sh.m);
+        int victim = 0;
+        for (int w = 0; w < WAYS; ++w) {
+            if (m.tag[w] == tag && entries[set * WAYS + w].key == key) return;  // 다른 스레드가 같은 read를 먼저 넣음
+            if (m.tag[w] == 0 || (m.tag[victim] != 0 && m.lastUse[w] < m.lastUse[victim])) victim = w;
+            if (m.tag[w] == 0) break;
+        }
+        sh.evictions += m.tag[victim] != 0;
+        m.tag[victim] = tag;
+        m.lastUse[victim] = ++sh.clock;
+        entries[set * WAYS + victim] = {key, res};
+    }
+
+    void clear() {
+        for (Shard& sh : shards) sh.m.lock();
+        fill(meta.begin(), meta.end(), SetMeta());
+        for (Shard& sh : shards) {
+            sh.clock = 0;
+            sh.evictions = 0;
+            sh.m.unlock();
+        }
+    }
+
+    // 현재 항목 수 (정렬이 끝난 뒤 통계용으로만 부르므로 잠그지 않음)
+    size_t size() const {
+        size_t n = 0;
+        for (const SetMeta& m : meta)
+            for (uint32_t t : m.tag) n += t != 0;
+        return n;
+    }
+
+    uint64_t evictions() {
+        uint64_t n = 0;
+        for (Shard& sh : shards) {
+            lock_guard<mutex> lk(sh.m);
+            n += sh.evictions;
+        }
+        return n;
+    }
+
+    size_t maxEntries() const { return entries.size(); }
+};
+
+// 정렬 통계 (스레드마다 따로 세고 끝에 합침)
+struct AlignStats {
+    long long reads = 0, mapped = 0;
+    long long recovered = 0;                       // 단일 접두사 경로로는 못 찾았던 read 수 (-DALIGNER_PROFILE 빌드에서만 셈)
+    long long forwardHits = 0, reverseHits = 0;    // 가닥별 매칭 수
+    long long editVerified = 0, editRescued = 0;   // 편집 거리로 검증한 후보 수, 그로 인해 결과가 나아진 read 수
+    long long multiMapped = 0, truncated = 0;      // best와 같은 mismatch의 다른 위치가 있는 read 수, 후보 상한에 걸린 read 수
+    long long cacheLookups = 0, cacheHits = 0;     // read 캐시 조회 수 (캐시할 수 있는 read), 적중 수
+    long long spacedHits[SPACED_SEED_COUNT] = {};  // 패턴별로 찾은 후보 수
+    long long pairs = 0, properPairs = 0;          // paired-end: 쌍 수, insert가 허용 구간 안인 쌍 수
+    long long rescueTried = 0, rescued = 0;        // mate rescue를 시도한 쌍 수, 결과가 바뀐 쌍 수
+
+    AlignStats& operator+=(const AlignStats& o) {
+        reads += o.reads;
+        mapped += o.mapped;
+        recovered += o.recovered;
+        forwardHits += o.forwardHits;
+        reverseHits += o.reverseHits;
+        editVerified += o.editVerified;
+        editRescued += o.editRescued;
+        multiMapped += o.multiMapped;
+        truncated += o.truncated;
+        cacheLookups += o.cacheLookups;
+        cacheHits += o.cacheHits;
+        for (int p = 0; p < SPACED_SEED_COUNT; ++p) spacedHits[p] += o.spacedHits[p];
+        pairs += o.pairs;
+        properPairs += o.properPairs;
+        rescueTried += o.rescueTried;
+        rescued += o.rescued;
+        return *this;
+    }
+};
+
+// 핫 경로 계측: -DALIGNER_PROFILE로 컴파일하면 스레드마다 카운터와 지연 시간 히스토그램을 따로 세고 출력할 때 합침
+// 없이 컴파일하면 add/record/ns가 모두 빈 inline 함수라 호출이 사라지고 시계도 읽지 않음
+#ifdef ALIGNER_PROFILE
+const bool PROFILE_ENABLED = true;
+#else
+const bool PROFILE_ENABLED = false;
+#endif
+
+struct Profile {
+    enum Counter {
+        Reads, NoMatch, SeedLookups, SeedHits, Candidates, SpacedRejects, Verifications, EarlyExits, EditVerifications,
+        COUNTER_COUNT
+    };
+    enum Histogram { SeedLatency, ReadLatency, IntervalSize, HISTOGRAM_COUNT };
+    static constexpr int BINS = 40;  // bin b = [2^(b-1), 2^b), bin 0 = 0
+    static constexpr const char* COUNTER_NAMES[COUNTER_COUNT] = {
+        "reads", "no_match", "seed_lookups", "seed_hits", "candidates", "spaced_rejects", "verifications", "early_exits",
+        "edit_verifications"};
+    static constexpr const char* HISTOGRAM_NAMES[HISTOGRAM_COUNT] = {"seed_lookup_ns", "read_align_ns", "sa_interval_size"};
+
+#ifdef ALIGNER_PROFILE
+    // 주기적 출력 스레드가 정렬 중에도 읽을 수 있도록 relaxed atomic (쓰는 스레드는 하나라 load + store로 충분, lock 없음)
+    atomic<uint64_t> counters[COUNTER_COUNT] = {};
+    atomic<uint64_t> bins[HISTOGRAM_COUNT][BINS] = {};
+
+    void add(Counter c, uint64_t n = 1) { counters[c].store(counters[c].load(memory_order_relaxed) + n, memory_order_relaxed); }
+    void record(Histogram h, uint64_t v, uint64_t weight = 1) {
+        int b = min(BINS - 1, v ? 64 - __builtin_clzll(v) : 0);
+        bins[h][b].store(bins[h][b].load(memory_order_relaxed) + weight, memory_order_relaxed);
+    }
+#else
+    void add(Counter, uint64_t = 1) {}
+    void record(Histogram, uint64_t, uint64_t = 1) {}
+#endif
+};
+
+// 구간 시간 측정 (계측을 끄면 시계를 읽지 않고 0)
+struct ProfileTimer {
+#ifdef ALIGNER_PROFILE
+    steady_clock::time_point start = steady_clock::now();
+    uint64_t ns() const { return duration_cast<nanoseconds>(steady_clock::now() - start).count(); }
+#else
+    uint64_t ns() const { return 0; }
+#endif
+};
+
+// 스레드별 Profile 목록 (정렬 함수가 끝난 뒤에도 합산할 수 있도록 프로세스가 끝날 때까지 유지)
+class ProfileRegistry {
+    mutex m;
+    vector<unique_ptr<Profile>> profiles;
+    steady_clock::time_point start = steady_clock::now();
+
+public:
+    Profile& create() {
+        lock_guard<mutex> lk(m);
+        profiles.push_back(make_unique<Profile>());
+        return *profiles.back();
+    }
+
+    // 모든 스레드의 값을 합쳐 JSON으로 기록 (히스토그램의 p50/p99는 해당 bin의 상한)
+    void dump(ostream& out) {
+        lock_guard<mutex> lk(m);
+        uint64_t counters[Profile::COUNTER_COUNT] = {}, bins[Profile::HISTOGRAM_COUNT][Profile::BINS] = {};
+#ifdef ALIGNER_PROFILE
+        for (auto& p : profiles) {
+            for (int c = 0; c < Profile::COUNTER_COUNT; ++c) counters[c] += p->counters[c].load(memory_order_relaxed);
+            for (int h = 0; h < Profile::HISTOGRAM_COUNT; ++h)
+                for (int b = 0; b < Profile::BINS; ++b) bins[h][b] += p->bins[h][b].load(memory_order_relaxed);
+        }
+#endif
+        auto ratio = [](uint64_t a, uint64_t b) { return b ? double(a) / b : 0.0; };
+        out << "{\n  \"elapsed_sec\": " << duration_cast<duration<double>>(steady_clock::now() - start).count()
+            << ",\n  \"thread_profiles\": " << profiles.size() << ",\n  \"counters\": {";
+        for (int c = 0; c < Profile::COUNTER_COUNT; ++c)
+            out << (c ? ", " : "") << "\"" << Profile::COUNTER_NAMES[c] << "\": " << counters[c];
+        out << "},\n  \"derived\": {\"avg_sa_interval\": " << ratio(counters[Profile::SeedHits], counters[Profile::SeedLookups])
+            << ", \"candidates_per_read\": " << ratio(counters[Profile::Candidates], counters[Profile::Reads])
+            << ", \"verifications_per_read\": " << ratio(counters[Profile::Verifications], counters[Profile::Reads])
+            << ", \"spaced_reject_rate\": "
+            << ratio(counters[Profile::SpacedRejects], counters[Profile::SpacedRejects] + counters[Profile::Verifications])
+            << "},\n  \"histograms\": {";
+        for (int h = 0; h < Profile::HISTOGRAM_COUNT; ++h) {
+            uint64_t total = accumulate(bins[h], bins[h] + Profile::BINS, uint64_t(0)), seen = 0, p50 = 0, p99 = 0;
+            bool has50 = false, has99 = false;
+            for (int b = 0; b < Profile::BINS && total; ++b) {
+                uint64_t upper = b ? (uint64_t(1) << b) - 1 : 0;
+                seen += bins[h][b];
+                if (!has50 && seen * 2 >= total) p50 = upper, has50 = true;
+                if (!has99 && seen * 100 >= total * 99) p99 = upper, has99 = true;
+            }
+            out << (h ? "," : "") << "\n    \"" << Profile::HISTOGRAM_NAMES[h] << "\": {\"count\": " << total << ", \"p50\": " << p50
+                << ", \"p99\": " << p99 << ", \"bins\": [";
+            bool first = true;
+            for (int b = 0; b < Profile::BINS; ++b) {
+                if (!bins[h][b]) continue;
+                out << (first ? "" : ", ") << "[" << (b ? (uint64_t(1) << b) - 1 : 0) << ", " << bins[h][b] << "]";
+                first = false;
+            }
+            out << "]}";
+        }
+        out << "\n  }\n}\n";
+    }
+
+    // 읽는 쪽이 쓰다 만 파일을 보지 않도록 임시 파일에 쓴 뒤 rename
+    void dump(const string& file) {
+        string tmp = file + ".tmp";
+        {
+            ofstream out(tmp);
+            dump(out);
+        }
+        rename(tmp.c_str(), file.c_str());
+    }
+};
+
+ProfileRegistry& profileRegistry() {
+    static ProfileRegistry registry;
+    return registry;
+}
+
+// 계측 결과를 file에 기록: interval초마다 (0이면 생략) 다시 쓰고, 소멸할 때 마지막으로 한 번 더 씀
+class ProfileDumper {
+    string file;
+    thread worker;
+    mutex m;
+    condition_variable cv;
+    bool stop = false;
+
+public:
+    ProfileDumper(const string& f, double interval) : file(f) {
+        if (interval <= 0) return;
+        worker = thread([this, interval] {
+            unique_lock<mutex> lk(m);
+            while (!cv.wait_for(lk, duration<double>(interval), [&] { return stop; })) profileRegistry().dump(file);
+        });
+    }
+
+    ~ProfileDumper() {
+        {
+            lock_guard<mutex> lk(m);
+            stop = true;
+        }
+        cv.notify_all();
+        if (worker.joinable()) worker.join();
+        profileRegistry().dump(file);
+    }
+};
+
+// 스레드 하나가 쓸 Profile (계측을 끄면 모두 같은 빈 객체)
+Profile& newProfile() {
+    static Profile unused;
+    return PROFILE_ENABLED ? profileRegistry().create() : unused;
+}
+
+// 스레드마다 재사용하는 작업 버퍼 (후보 검증 루프에서 할당이 없도록)
+struct AlignScratch {
+    PackedRead packed;
+    vector<uint64_t> cands;    // (diagonal << 1) | 첫 시드 후보 여부
+    string rc;                 // 역상보 서열 버퍼
+    vector<Pos> editCands;     // 편집 거리 검증 대상 위치 (필터를 통과한 후보)
+    vector<pair<int, Pos>> editHits; // editCands별 (편집 거리, 정렬 끝 위치), 건너뛴 후보는 거리 -1
+    vector<uint64_t> peq, vp, vm;  // Myers 비트 벡터 (read 64염기 블록 단위)
+    vector<int> dp;            // CIGAR 역추적용 DP 표
+    // 시드 정렬 경로 (alignBlockSorted): read 묶음 전체의 결과와 정렬 순서
+    vector<uint64_t> seedOrder, seedRev, seedTmp;  // (시드 키 << 32 | 묶음 안 read 번호), 정방향/역방향/radix 버퍼
+    vector<int> seedLane;                 // 정렬 순서 j번째 read가 쓰는 묶음 이진 탐색 갈래
+    vector<char> rcSeeds;                 // read별 역상보 첫 시드 (SEED_LEN바이트씩)
+    vector<AlignResult> blockRes;
+    vector<uint64_t> blockNs;
+    vector<CacheKey> blockKeys;
+    vector<char> blockCached;
+    AlignStats stats;
+    Profile& prof = newProfile();
+};
+
+// 시드 구간 검색 결과 계측 (찾은 구간 크기)
+inline void profileSeedRange(Profile& prof, pair<Pos, Pos> range, uint64_t ns, uint64_t weight = 1) {
+    prof.add(Profile::SeedLookups, weight);
+    prof.add(Profile::SeedHits, range.second - range.first);
+    prof.record(Profile::IntervalSize, range.second - range.first);
+    prof.record(Profile::SeedLatency, ns, weight);
+}
+
+// 시드 하나의 SA(또는 FM) 구간 검색 + 계측
+pair<Pos, Pos> lookupSeed(const SAIndex& idx, string_view seed, Profile& prof) {
+    ProfileTimer timer;
+    pair<Pos, Pos> range = seedRange(idx, seed);
+    profileSeedRange(prof, range, timer.ns());
+    return range;
+}
+
+// Myers 비트 병렬 편집 거리의 64행 블록 한 열 진행 (hin/hout: 블록 위/아래 경계의 수평 차이 -1, 0, 1)
+// high: 점수를 읽을 행의 비트 (마지막 블록은 read 마지막 행, 그 위 비트의 값은 아래 행에 영향 없음)
+inline int advanceBlock(uint64_t& pv, uint64_t& mv, uint64_t eq, int hin, uint64_t high) {
+    uint64_t hinNeg = hin < 0, hinPos = hin > 0;
+    uint64_t xv = eq | mv;
+    eq |= hinNeg;
+    uint64_t xh = (((eq & pv) + pv) ^ pv) | eq;
+    uint64_t ph = mv | ~(xh | pv);
+    uint64_t mh = pv & xh;
+    int hout = (ph & high) ? 1 : (mh & high) ? -1 : 0;
+    ph = (ph << 1) | hinPos;
+    mh = (mh << 1) | hinNeg;
+    pv = mh | ~(xv | ph);
+    mv = ph & xv;
+    return hout;
+}
+
+// read의 염기별 일치 비트 (peq[c * blocks + b]의 i번째 비트 = read[64b + i]가 염기 c), ACGT 외 문자는 어느 염기와도 불일치
+void buildPeq(string_view read, vector<uint64_t>& peq) {
+    int blocks = (read.size() + 63) / 64;
+    peq.assign(4 * blocks, 0);
+    for (size_t i = 0; i < read.size(); ++i) {
+        int c = baseCode(read[i]);
+        if (c >= 0) peq[c * blocks + i / 64] |= 1ULL << (i % 64);
+    }
+}
+
+// reference [lo, hi) 안에서 read 전체를 맞출 때의 최소 편집 거리 (read 양 끝은 reference 어디서든 시작/끝날 수 있음)
+// end: 최소 편집 거리가 처음 나오는 reference 끝 위치 (배타적)
+int myersDistance(const PackedRef& ref, Pos lo, Pos hi, int len, AlignScratch& scratch, Pos& end) {
+    int blocks = (len + 63) / 64;
+    scratch.vp.assign(blocks, ~0ULL);
+    scratch.vm.assign(blocks, 0);
+    uint64_t* pv = scratch.vp.data();
+    uint64_t* mv = scratch.vm.data();
+    uint64_t lastHigh = 1ULL << ((len - 1) % 64);
+    int score = len, best = len + 1;
+    for (Pos j = lo; j < hi; ++j) {
+        const uint64_t* eq = scratch.peq.data() + ref.code(j) * blocks;
+        int h = 0;
+        for (int b = 0; b < blocks; ++b) h = advanceBlock(pv[b], mv[b], eq[b], h, b == blocks - 1 ? lastHigh : 1ULL << 63);
+        score += h;
+        if (score < best) {
+            best = score;
+            end = j + 1;
+        }
+    }
+    return best;
+}
+
+// reference [lo, end)에 read를 맞춘 DP 표를 역추적하여 시작 위치와 CIGAR 계산 (M: 일치/불일치, I: read에만 있음, D: reference에만 있음)
+Pos editTraceback(const PackedRef& ref, string_view read, Pos lo, Pos end, AlignScratch& scratch, string& cigar) {
+    int m = read.size(), w = end - lo;
+    vector<int>& dp = scratch.dp;
+    dp.assign((size_t)(m + 1) * (w + 1), 0);
+    auto at = [&](int i, int j) -> int& { return dp[(size_t)i * (w + 1) + j]; };
+    for (int i = 1; i <= m; ++i) {
+        at(i, 0) = i;
+        int c = baseCode(read[i - 1]);
+        for (int j = 1; j <= w; ++j)
+            at(i, j) = min({at(i - 1, j - 1) + (c != ref.code(lo + j - 1)), at(i - 1, j) + 1, at(i, j - 1) + 1});
+    }
+
+    string ops;
+    int i = m, j = w;
+    while (i > 0) {
+        if (j > 0 && at(i, j) == at(i - 1, j - 1) + (baseCode(read[i - 1]) != ref.code(lo + j - 1))) {
+            ops += 'M';
+            --i, --j;
+        } else if (at(i, j) == at(i - 1, j) + 1) {
+            ops += 'I';
+            --i;
+        } else {
+            ops += 'D';
+            --j;
+        }
+    }
+    cigar.clear();
+    for (size_t k = ops.size(); k > 0;) {
+        size_t run = 0;
+        char op = ops[k - 1];
+        while (k > 0 && ops[k - 1] == op) --k, ++run;
+        cigar += to_string(run);
+        cigar += op;
+    }
+    return lo + j;
+}
+
+// 편집 거리 검증: Hamming 결과가 0, 1이면 indel로 더 줄어들 수 없으므로 그대로 두고,
+// 그 외에는 필터를 통과한 후보마다 diagonal ± MAX_ERROR 밴드에서 Myers 편집 거리를 계산해 더 나은 것을 채택
+// second는 정렬 끝 위치가 최종 결과와 MAX_ERROR보다 멀리 떨어진 (다른 위치를 가리키는) 후보의 편집 거리로 갱신
+void verifyEditDistance(const SAIndex& idx, string_view read, AlignScratch& scratch, AlignResult& res) {
+    int len = read.size();
+    Pos refLen = idx.reference.size();
+    if (res.pos != -1 && res.mismatch <= 1) {
+        res.cigar = to_string(len) + "M";
+        return;
+    }
+    auto& cands = scratch.editCands;
+    sort(cands.begin(), cands.end());
+    cands.erase(unique(cands.begin(), cands.end()), cands.end());
+
+    auto& hits = scratch.editHits;
+    hits.assign(cands.size(), {-1, 0});
+
+    int best = min(res.mismatch, MAX_ERROR + 1);
+    Pos bestLo = 0, bestEnd = 0;
+    if (!cands.empty()) buildPeq(read, scratch.peq);
+    for (size_t c = 0; c < cands.size(); ++c) {
+        Pos diag = cands[c];
+        // 밴드는 후보가 속한 contig 안, 양옆 N 구간 사이로 자름 (read 자리 자체가 N과 겹치는 후보만 건너뜀)
+        if (!idx.layout.inside(diag, len)) continue;
+        Pos lo = max<Pos>(0, diag - MAX_ERROR), hi = min<Pos>(refLen, diag + len + MAX_ERROR);
+        if (idx.layout.contigs.size() > 1) {
+            const Contig& c = idx.layout.contigs[idx.layout.contigOf(diag)];
+            lo = max<int64_t>(lo, c.start);
+            hi = min<int64_t>(hi, c.start + c.length);
+        }
+        auto gap = idx.layout.nGap(diag);
+        lo = max<uint64_t>(lo, gap.first);
+        hi = min<uint64_t>(hi, gap.second);
+        Pos end = 0;
+        int d = myersDistance(idx.reference, lo, hi, len, scratch, end);
+        hits[c] = {d, end};
+        scratch.stats.editVerified++;
+        scratch.prof.add(Profile::EditVerifications);
+        if (d < best) {
+            best = d;
+            bestLo = lo;
+            bestEnd = end;
+        }
+    }
+    if (best < min(res.mismatch, MAX_ERROR + 1)) {
+        res.pos = editTraceback(idx.reference, read, bestLo, bestEnd, scratch, res.cigar);
+        res.mismatch = best;
+        res.second = MAX_ERROR + 1;
+        res.edited = true;
+    } else if (res.pos != -1) {
+        res.cigar = to_string(len) + "M";
+        bestEnd = res.pos + len;
+    } else {
+        return;
+    }
+    for (auto [d, end] : hits)
+        if (d >= 0 && abs(end - bestEnd) > MAX_ERROR) res.second = min(res.second, d);
+}
+
+// 기존 방식: read 앞 SEED_LEN 염기 하나로 찾은 SA 구간의 후보를 검증
+// range: 미리 찾은 첫 시드의 SA 구간
+// 구간이 opt.maxCandidates 이하면 SA 순서대로 모두 검증하고, 넘으면 (반복 영역) opt.maxCandidates개만 우선순위대로 검증:
+//  SA 백엔드: 구간 안에서 read 전체의 삽입 위치를 찾아 양옆으로 번갈아 (사전순으로 가까울수록 read와 공통 접두사가 김)
+//  FM 백엔드: 위치마다 locate가 필요하므로 구간 전체에서 고른 간격으로
+// best가 같은 후보가 여럿이면 SA 순서가 앞선 것을 택하므로, 상한에 걸리지 않은 read의 결과는 모두 검증할 때와 같음
+AlignResult alignSinglePrefix(const SAIndex& idx, string_view read, pair<Pos, Pos> range, AlignScratch& scratch,
+                              const AlignOptions& opt) {
+    const PackedRef& reference = idx.reference;
+    AlignResult res;
+    auto [l, r] = range;
+    Pos bestJ = r;
+
+    // 구간 안 j번째 후보 검증, 더 볼 필요가 없으면 true
+    auto verify = [&](Pos j) {
+        Pos pos = seedPos(idx, j);
+        scratch.prof.add(Profile::Candidates);
+        if (pos + read.size() > reference.size() || !idx.layout.inside(pos, read.size())) return false;
+        if (!spacedSeedMatch(reference, scratch.packed, pos)) {
+            scratch.prof.add(Profile::SpacedRejects);
+            return false;
+        }
+        if (opt.editDistance) scratch.editCands.push_back(pos);
+
+        int limit = candidateLimit(res);
+        int mismatch = opt.countMismatch(reference, pos, scratch.packed, limit);
+        scratch.prof.add(Profile::Verifications);
+        bool earlier = mismatch <= limit && mismatch == res.mismatch && j < bestJ;
+        if (mismatch < res.mismatch || earlier) bestJ = j;
+        if (!updateBest(res, pos, mismatch, earlier)) return false;
+        scratch.prof.add(Profile::EarlyExits);
+        return true;
+    };
+
+    if (r - l <= opt.maxCandidates) {
+        for (Pos j = l; j < r && !verify(j); ++j) {
+        }
+    } else if (idx.backend == IndexBackend::SA) {
+        res.truncated = true;
+        Pos hi = findPrefixRangeIn(reference, idx.sa, read, l, r).first, lo = hi - 1;
+        for (int k = 0; k < opt.maxCandidates; ++k) {
+            bool right = hi < r && (k % 2 == 0 || lo < l);
+            if (verify(right ? hi++ : lo--)) break;
+        }
+    } else {
+        res.truncated = true;
+        for (int k = 0; k < opt.maxCandidates; ++k)
+            if (verify(l + Pos((int64_t)k * (r - l) / opt.maxCandidates))) break;
+    }
+    res.prefixHit = res.pos != -1;
+    return res;
+}
+
+// 후보 diagonal 기반 정렬: SA 시드(첫 시드, multiSeed면 겹치지 않는 모든 SEED_LEN 시드)와
+// 활성 spaced seed 인덱스에서 찾은 위치를 diagonal(pos - 시드 오프셋)로 모아 정렬/중복 제거 후 diagonal마다 한 번만 검증
+// 앞쪽 시드에 mismatch가 있어 기존 경로로는 "no match"였던 read도 다른 시드로 찾을 수 있음
+AlignResult alignCandidates(const SAIndex& idx, string_view read, AlignScratch& scratch, const AlignOptions& opt) {
+    const PackedRef& reference = idx.reference;
+    const PackedRead& packed = scratch.packed;
+    int len = read.size();
+    Pos refLen = reference.size();
+    auto& cands = scratch.cands;
+    cands.clear();
+    bool truncated = false;
+
+    for (int off = 0; off == 0 || (opt.multiSeed && off + SEED_LEN <= len); off += SEED_LEN) {
+        auto [l, r] = lookupSeed(idx, read.substr(off, SEED_LEN), scratch.prof);
+        truncated |= r - l > opt.maxSeedHits;
+        r = min(r, l + opt.maxSeedHits);
+        for (Pos j = l; j < r; ++j) {
+            Pos diag = seedPos(idx, j) - off;
+            if (diag < 0 || diag + len > refLen) continue;
+            cands.push_back((uint64_t)diag << 1 | (off == 0));
+        }
+    }
+
+    forEachSpacedSeed([&](auto seed) {
+        using Seed = decltype(seed);
+        if (!(opt.spacedSeeds >> Seed::id & 1)) return;
+        PosView index = idx.spaced[Seed::id];
+        for (int off = 0; off + Seed::span <= len; off += SPACED_SEED_PERIOD) {
+            if (PackedRead::window(packed.nmask, off) & Seed::mask) continue; // 패턴 위치에 ACGT 외 문자
+            ProfileTimer timer;
+            auto [l, r] = Seed::lookup(reference, index, PackedRead::window(packed.words, off));
+            profileSeedRange(scratch.prof, {l, r}, timer.ns());
+            truncated |= r - l > opt.maxSeedHits;
+            r = min(r, l + opt.maxSeedHits);
+            scratch.stats.spacedHits[Seed::id] += r - l;
+            for (Pos j = l; j < r; ++j) {
+                Pos diag = index[j] - off;
+                if (diag < 0 || diag + len > refLen) continue;
+                cands.push_back((uint64_t)diag << 1);
+            }
+        }
+    });
+    sort(cands.begin(), cands.end());
+
+    AlignResult res;
+    res.truncated = truncated;
+    size_t k = 0;
+    // 중복 diagonal을 하나로 합치며 (첫 시드 후보 여부는 OR) 순서대로 처리
+    auto next = [&](Pos& diag, bool& fromPrefix) {
+        if (k >= cands.size()) return false;
+        diag = cands[k] >> 1;
+        fromPrefix = false;
+        for (; k < cands.size() && (Pos)(cands[k] >> 1) == diag; ++k) fromPrefix |= cands[k] & 1;
+        return true;
+    };
+
+    Pos diag;
+    bool fromPrefix;
+    while (next(diag, fromPrefix)) {
+        scratch.prof.add(Profile::Candidates);
+        if (!idx.layout.inside(diag, len)) continue;
+        if (!spacedSeedMatch(reference, scratch.packed, diag)) {
+            scratch.prof.add(Profile::SpacedRejects);
+            continue;
+        }
+        if (opt.editDistance) scratch.editCands.push_back(diag);
+        // 계측 빌드에서는 기존 경로의 매칭 여부(recovered 통계)를 알아야 하므로 첫 시드 후보를 MAX_ERROR까지 셈
+        bool checkPrefix = PROFILE_ENABLED && fromPrefix && !res.prefixHit;
+        int mismatch = opt.countMismatch(reference, diag, scratch.packed, checkPrefix ? MAX_ERROR : candidateLimit(res));
+        scratch.prof.add(Profile::Verifications);
+        if (checkPrefix && mismatch <= MAX_ERROR) res.prefixHit = true;
+        if (updateBest(res, diag, mismatch)) {
+            scratch.prof.add(Profile::EarlyExits);
+            break;
+        }
+    }
+    // 계측 빌드에서는 조기 종료한 경우에도 남은 첫 시드 후보로 기존 경로의 매칭 여부를 마저 확인
+    while (PROFILE_ENABLED && !res.prefixHit && res.pos != -1 && next(diag, fromPrefix)) {
+        if (fromPrefix && idx.layout.inside(diag, len) && spacedSeedMatch(reference, scratch.packed, diag)) {
+            scratch.prof.add(Profile::Verifications);
+            if (opt.countMismatch(reference, diag, scratch.packed, MAX_ERROR) <= MAX_ERROR) res.prefixHit = true;
+        }
+    }
+    return res;
+}
+
+// 역상보 서열을 out에 기록 (ACGT 외 문자는 그대로 두어 mismatch로 셈)
+void reverseComplement(string_view read, string& out) {
+    out.resize(read.size());
+    for (size_t i = 0; i < read.size(); ++i) {
+        char c = read[read.size() - 1 - i];
+        out[i] = c == 'A' ? 'T' : c == 'C' ? 'G' : c == 'G' ? 'C' : c == 'T' ? 'A' : c;
+    }
+}
+
+// 한 가닥 정렬 (옵션에 따라 경로 선택)
+// prefixRange: 단일 접두사 경로에서 미리 찾아 둔 첫 시드 구간 (없으면 여기서 검색)
+AlignResult alignStrand(const SAIndex& idx, string_view read, AlignScratch& scratch, const AlignOptions& opt,
+                        const pair<Pos, Pos>* prefixRange) {
+    scratch.packed.assign(read);
+    scratch.editCands.clear();
+    AlignResult res = (opt.multiSeed || opt.spacedSeeds)
+                          ? alignCandidates(idx, read, scratch, opt)
+                          : alignSinglePrefix(idx, read,
+                                              prefixRange ? *prefixRange : lookupSeed(idx, read.substr(0, SEED_LEN), scratch.prof),
+                                              scratch, opt);
+    if (opt.editDistance) verifyEditDistance(idx, read, scratch, res);
+    return res;
+}
+
+// 정방향 가닥에서 mismatch 없이 매칭되면 역방향은 볼 필요 없음
+bool needReverse(const AlignResult& fwd, const AlignOptions& opt) { return opt.bothStrands && fwd.mismatch != 0; }
+
+// 역방향 가닥 정렬 (역상보 서열은 스레드별 버퍼에 만듦), 정방향보다 mismatch가 적을 때만 채택
+// 채택되지 않은 가닥의 best는 second 후보가 됨
+void alignReverse(const SAIndex& idx, string_view read, AlignScratch& scratch, const AlignOptions& opt,
+                  const pair<Pos, Pos>* prefixRange, AlignResult& res) {
+    reverseComplement(read, scratch.rc);
+    AlignResult rev = alignStrand(idx, scratch.rc, scratch, opt, prefixRange);
+    bool truncated = res.truncated || rev.truncated;
+    if (rev.pos != -1 && rev.mismatch < res.mismatch) {
+        rev.second = min(rev.second, res.mismatch);
+        res = rev;
+        res.reverse = true;
+    } else {
+        res.second = min(res.second, rev.mismatch);
+    }
+    res.truncated = truncated;
+}
+
+// 최종 결과 확정 후 통계 갱신 (ns: read 하나의 정렬 시간, 계측용)
+void finishRead(AlignResult& res, AlignScratch& scratch, uint64_t ns) {
+    AlignStats& stats = scratch.stats;
+    bool ok = res.pos != -1 && res.mismatch <= MAX_ERROR;
+    if (!ok) res.pos = -1;
+    res.mapq = ok ? mappingQuality(res) : 0;
+    scratch.prof.add(Profile::Reads);
+    scratch.prof.add(Profile::NoMatch, !ok);
+    scratch.prof.record(Profile::ReadLatency, ns);
+    stats.reads++;
+    stats.mapped += ok;
+    stats.recovered += ok && !res.prefixHit;
+    stats.forwardHits += ok && !res.reverse;
+    stats.reverseHits += ok && res.reverse;
+    stats.editRescued += ok && res.edited;
+    stats.multiMapped += ok && res.second <= res.mismatch;
+    stats.truncated += res.truncated;
+}
+
+// read 하나를 양쪽 가닥에서 정렬
+AlignResult alignRead(const SAIndex& idx, string_view read, AlignScratch& scratch, const AlignOptions& opt) {
+    ProfileTimer timer;
+    AlignResult res = alignStrand(idx, read, scratch, opt, nullptr);
+    if (needReverse(res, opt)) alignReverse(idx, read, scratch, opt, nullptr, res);
+    finishRead(res, scratch, timer.ns());
+    return res;
+}
+
+// ✅ 결과 출력
+// 형식별 함수가 스레드별 버퍼 뒤에 결과를 덧붙이고, 버퍼가 다 차면 OutputFile로 write() 한 번에 기록
+// binary 형식: [OutputHeader][contig 표 (serializeContigs와 같은 배치)][read index 순서의 OutputRecord × read 수]
+const char OUTPUT_MAGIC[8] = {'S', 'R', 'A', 'O', 'U', 'T', '\0', '\0'};
+const uint32_t OUTPUT_VERSION = 1;
+
+struct OutputHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t recordSize;   // sizeof(OutputRecord)
+    uint64_t contigCount;
+    uint64_t contigBytes;
+};
+
+// 매칭된 가닥·상태 비트 (OutputRecord::flags)
+// paired-end 모드는 쌍마다 레코드 두 개(readIndex = 쌍 index)이고 mate 2 레코드에 OUT_MATE2를 붙임
+const uint8_t OUT_REVERSE = 1, OUT_MULTI_MAPPED = 2, OUT_EDITED = 4, OUT_TRUNCATED = 8;
+const uint8_t OUT_MATE2 = 16, OUT_PROPER_PAIR = 32, OUT_RESCUED = 64;
+
+struct OutputRecord {
+    uint64_t readIndex;
+    uint64_t pos;         // contig 안 위치 (매칭 없으면 UINT64_MAX)
+    uint32_t contig;      // contig 번호 (매칭 없으면 UINT32_MAX)
+    uint8_t mismatch;     // mismatch 수 (편집 거리 모드면 편집 거리, CIGAR는 담지 않음)
+    uint8_t mapq;
+    uint8_t flags;
+    uint8_t reserved;
+};
+static_assert(sizeof(OutputRecord) == 24, "OutputRecord는 24바이트 고정");
+
+// SAM의 RNAME (이름 없는 단일 서열은 "ref")
+string_view samName(const Contig& c) { return c.name.empty() ? string_view("ref") : string_view(c.name); }
+
+// 정렬 전에 한 번 쓰는 형식별 헤더 (text는 없음)
+void formatHeader(string& out, const RefLayout& layout, OutputFormat format) {
+    if (format == OutputFormat::Binary) {
+        string contigBlob = serializeContigs(layout);
+        OutputHeader h{};
+        memcpy(h.magic, OUTPUT_MAGIC, sizeof(h.magic));
+        h.version = OUTPUT_VERSION;
+        h.recordSize = sizeof(OutputRecord);
+        h.contigCount = layout.contigs.size();
+        h.contigBytes = contigBlob.size();
+        out.append((const char*)&h, sizeof(h));
+        out += contigBlob;
+    } else if (format == OutputFormat::SAM) {
+        out += "@HD\tVN:1.6\tSO:unsorted\n";
+        for (const Contig& c : layout.contigs) {
+            out += "@SQ\tSN:";
+            out += samName(c);
+            out += "\tLN:";
+            appendInt(out, c.length);
+            out += '\n';
+        }
+        out += "@PG\tID:aligner\tPN:aligner\n";
+    }
+}
+
+// 매칭 하나: "pos: P, mismatch: X, strand: +, mapq: Q[, multi-mapped][, cigar: C]" 또는 "no match"
+void formatMatch(string& out, const AlignResult& res, const RefLayout& layout) {
+    if (res.pos == -1) {
+        out += "no match";
+        return;
+    }
+    out += "pos: ";
+    layout.format(out, res.pos);
+    out += ", mismatch: ";
+    appendInt(out, res.mismatch);
+    out += res.reverse ? ", strand: -" : ", strand: +";
+    out += ", mapq: ";
+    appendInt(out, res.mapq);
+    if (res.second <= res.mismatch) out += ", multi-mapped";
+    if (!res.cigar.empty()) {
+        out += ", cigar: ";
+        out += res.cigar;
+    }
+}
+
+// text: "read index: i -> " + formatMatch
+void formatText(string& out, size_t index, const AlignResult& res, const RefLayout& layout) {
+    out += "read index: ";
+    appendInt(out, index);
+    out += " -> ";
+    formatMatch(out, res, layout);
+    out += '\n';
+}
+
+// flags: 매칭 여부와 무관하게 붙일 비트 (paired-end의 mate 번호, proper pair, rescue)
+void formatBinary(string& out, size_t index, const AlignResult& res, const RefLayout& layout, uint8_t flags = 0) {
+    OutputRecord r{};
+    r.readIndex = index;
+    r.pos = UINT64_MAX;
+    r.contig = UINT32_MAX;
+    r.flags = flags;
+    if (res.pos != -1) {
+        int c = layout.contigOf(res.pos);
+        r.pos = res.pos - layout.contigs[c].start;
+        r.contig = c;
+        r.mismatch = res.mismatch;
+        r.mapq = res.mapq;
+        r.flags |= (res.reverse ? OUT_REVERSE : 0) | (res.second <= res.mismatch ? OUT_MULTI_MAPPED : 0) |
+                   (res.edited ? OUT_EDITED : 0) | (res.truncated ? OUT_TRUNCATED : 0);
+    }
+    out.append((const char*)&r, sizeof(r));
+}
+
+// paired-end SAM 레코드의 짝 정보: FLAG에 더할 비트(0x1, 0x2, 0x40/0x80), 짝 mate의 결과, TLEN
+struct SamMate {
+    int flags;
+    const AlignResult* mate;
+    long long tlen;
+};
+
+// 최소 SAM: QNAME은 read index (paired-end면 쌍 index), QUAL은 '*', 역방향이면 SEQ를 역상보로 기록, 태그는 NM만
+// pair가 있으면 짝 mate의 가닥/매칭 여부를 FLAG에, 위치를 RNEXT/PNEXT에 기록
+void formatSAM(string& out, size_t index, string_view read, const AlignResult& res, const RefLayout& layout,
+               const SamMate* pair = nullptr) {
+    int flags = pair ? pair->flags : 0;
+    if (pair && pair->mate->pos == -1) flags |= 0x8;
+    if (pair && pair->mate->pos != -1 && pair->mate->reverse) flags |= 0x20;
+    auto mateFields = [&] {
+        if (!pair || pair->mate->pos == -1) {
+            out += "\t*\t0\t0\t";
+            return;
+        }
+        int mc = layout.contigOf(pair->mate->pos);
+        out += '\t';
+        if (res.pos != -1 && layout.contigOf(res.pos) == mc) out += '=';
+        else out += samName(layout.contigs[mc]);
+        out += '\t';
+        appendInt(out, pair->mate->pos - layout.contigs[mc].start + 1);
+        out += '\t';
+        appendInt(out, pair->tlen);
+        out += '\t';
+    };
+
+    appendInt(out, index);
+    if (res.pos == -1) {
+        out += '\t';
+        appendInt(out, flags | 0x4);
+        out += "\t*\t0\t0\t*";
+        mateFields();
+        out += read;
+        out += "\t*\n";
+        return;
+    }
+    const Contig& c = layout.contigs[layout.contigOf(res.pos)];
+    out += '\t';
+    appendInt(out, flags | (res.reverse ? 0x10 : 0));
+    out += '\t';
+    out += samName(c);
+    out += '\t';
+    appendInt(out, res.pos - c.start + 1);
+    out += '\t';
+    appendInt(out, res.mapq);
+    out += '\t';
+    if (res.cigar.empty()) {
+        appendInt(out, read.size());
+        out += 'M';
+    } else {
+        out += res.cigar;
+    }
+    mateFields();
+    if (res.reverse) {
+        size_t at = out.size();
+        out.resize(at + read.size());
+        for (size_t i = 0; i < read.size(); ++i) {
+            char b = read[read.size() - 1 - i];
+            out[at + i] = b == 'A' ? 'T' : b == 'C' ? 'G' : b == 'G' ? 'C' : b == 'T' ? 'A' : b;
+        }
+    } else {
+        out += read;
+    }
+    out += "\t*\tNM:i:";
+    appendInt(out, res.mismatch);
+    out += '\n';
+}
+
+// 결과 하나를 형식에 맞춰 out 뒤에 덧붙임
+void formatResult(string& out, size_t index, string_view read, const AlignResult& res, const RefLayout& layout,
+                  OutputFormat format) {
+    switch (format) {
+        case OutputFormat::Text: formatText(out, index, res, layout); break;
+        case OutputFormat::Binary: formatBinary(out, index, res, layout); break;
+        case OutputFormat::SAM: formatSAM(out, index, read, res, layout); break;
+    }
+}
+
+const char* formatName(OutputFormat format) {
+    return format == OutputFormat::Binary ? "binary" : format == OutputFormat::SAM ? "sam" : "text";
+}
+
+// 결과 파일: 버퍼 하나를 write() 한 번으로 기록 (ofstream 버퍼를 거치지 않음, 부분 기록이면 나머지를 이어서 씀)
+class OutputFile {
+    int fd = -1;
+    uint64_t written = 0;
+
+public:
+    explicit OutputFile(const string& file) { fd = ::open(file.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644); }
+    ~OutputFile() {
+        if (fd >= 0) ::close(fd);
+    }
+    OutputFile(const OutputFile&) = delete;
+    OutputFile& operator=(const OutputFile&) = delete;
+
+    bool isOpen() const { return fd >= 0; }
+    uint64_t bytes() const { return written; }
+
+    // 닫기 오류(지연된 기록 실패)도 실패로 봄
+    bool close() {
+        int r = ::close(fd);
+        fd = -1;
+        return r == 0;
+    }
+
+    bool write(string_view buf) {
+        while (!buf.empty()) {
+            ssize_t n = ::write(fd, buf.data(), buf.size());
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) return false;
+            buf.remove_prefix(n);
+            written += n;
+        }
+        return true;
+    }
+};
+
+// 캐시에 같은 서열 read의 결과가 있으면 res에 복사 (key는 정렬 후 결과를 넣을 때 씀, 캐시할 수 없으면 key.len = 0)
+bool findCached(const AlignOptions& opt, string_view read, CacheKey& key, AlignResult& res, AlignStats& stats) {
+    key.len = 0;
+    if (!opt.cache || !ReadCache::makeKey(read, key)) return false;
+    stats.cacheLookups++;
+    if (!opt.cache->find(key, res)) return false;
+    stats.cacheHits++;
+    return true;
+}
+
+// read 하나를 캐시를 거쳐 정렬 (캐시에 없으면 정렬한 뒤 넣음)
+AlignResult alignCached(const SAIndex& idx, string_view read, AlignScratch& scratch, const AlignOptions& opt) {
+    ProfileTimer timer;
+    CacheKey key;
+    AlignResult res;
+    if (findCached(opt, read, key, res, scratch.stats)) {
+        finishRead(res, scratch, timer.ns());
+    } else {
+        res = alignRead(idx, read, scratch, opt);
+        if (key.len) opt.cache->insert(key, res);
+    }
+    return res;
+}
+
+// order = (시드 키 << 32 | 번호)를 키 순서로 정렬한 뒤, 서로 다른 시드 group개씩 묶음 이진 탐색하여 번호마다 visit(번호, 구간, 시드 검색 ns)
+// 키 순서 = 사전순이므로 묶음의 시드는 모두 앞 묶음 마지막 시드 이상 → 그 시드의 왼쪽 경계부터 탐색 (ACGT 외 문자가 있는 시드는 맨 뒤, 처음부터)
+// 앞 번호와 시드가 같으면 같은 갈래의 구간을 그대로 씀
+template <class SeedOf, class Visit>
+void searchSortedSeeds(const SAIndex& idx, vector<uint64_t>& order, vector<uint64_t>& tmp, vector<int>& lane, int group,
+                       SeedOf&& seedOf, Visit&& visit) {
+    radixSortSeeds(order, tmp);
+    lane.resize(order.size());
+    string_view seeds[MAX_SEARCH_BATCH];
+    pair<Pos, Pos> ranges[MAX_SEARCH_BATCH];
+    Pos from = 0;
+    for (size_t m = 0, end = 0; m < order.size(); m = end) {
+        int lanes = 0;
+        for (end = m; end < order.size(); ++end) {
+            uint32_t key = order[end] >> 32;
+            bool same = end > m && key != SEED_UNSORTABLE && key == order[end - 1] >> 32;
+            if (!same && lanes == group) break;
+            if (!same) seeds[lanes++] = seedOf((uint32_t)order[end]);
+            lane[end] = lanes - 1;
+        }
+        bool sorted = (order[end - 1] >> 32) != SEED_UNSORTABLE;
+        ProfileTimer timer;
+        findPrefixRangeBatch(idx.reference, idx.sa, seeds, lanes, ranges, sorted ? from : 0);
+        uint64_t perSeed = timer.ns() / (end - m);
+        if (sorted) from = ranges[lanes - 1].first;
+        for (size_t j = m; j < end; ++j) visit((uint32_t)order[j], ranges[lane[j]], perSeed);
+    }
+}
+
+// 시드 정렬 경로 (opt.sortSeeds): 묶음 전체 read의 첫 시드를 2비트 코드로 radix 정렬한 순서로 묶음 이진 탐색
+// → 이웃한 탐색이 SA의 같은 경로를 지나 캐시 라인을 나눠 쓰고, 앞 갈래 묶음의 마지막 시드의 왼쪽 경계부터 탐색을 시작하며,
+//   앞 read와 같은 시드는 다시 찾지 않음. 역방향이 필요한 read의 역상보 첫 시드도 같은 방식으로 한 번 더 정렬해 찾음
+// 결과는 묶음 전체를 정렬한 뒤 원래 read 순서로 넘기므로 출력은 정렬하지 않은 경로와 같음
+template <class GetRead, class Emit>
+void alignBlockSorted(const SAIndex& idx, size_t count, GetRead&& getRead, AlignScratch& scratch, const AlignOptions& opt,
+                      int group, Emit&& emit) {
+    auto& res = scratch.blockRes;
+    auto& readNs = scratch.blockNs;
+    auto& keys = scratch.blockKeys;
+    auto& cached = scratch.blockCached;
+    auto& order = scratch.seedOrder;
+    res.assign(count, AlignResult());
+    readNs.assign(count, 0);
+    keys.resize(count);
+    cached.assign(count, 0);
+    scratch.rcSeeds.resize(count * SEED_LEN);
+
+    order.clear();
+    for (size_t i = 0; i < count; ++i) {
+        ProfileTimer timer;
+        cached[i] = findCached(opt, getRead(i), keys[i], res[i], scratch.stats);
+        readNs[i] = timer.ns();
+        if (!cached[i]) order.push_back((uint64_t)seedKey(getRead(i).substr(0, SEED_LEN)) << 32 | i);
+    }
+    // 정방향 뒤 역방향이 필요한 read는 seedRev에 (키는 역상보 첫 시드)
+    auto& reverse = scratch.seedRev;
+    reverse.clear();
+    searchSortedSeeds(idx, order, scratch.seedTmp, scratch.seedLane, group,
+                      [&](int i) { return getRead(i).substr(0, SEED_LEN); },
+                      [&](int i, const pair<Pos, Pos>& range, uint64_t perSeed) {
+                          profileSeedRange(scratch.prof, range, perSeed);
+                          ProfileTimer timer;
+                          string_view read = getRead(i);
+                          res[i] = alignStrand(idx, read, scratch, opt, &range);
+                          readNs[i] += perSeed + timer.ns();
+                          if (!needReverse(res[i], opt)) return;
+                          string_view tail = read.substr(read.size() - min<size_t>(read.size(), SEED_LEN));
+                          reverseComplement(tail, scratch.rc);
+                          char* seed = &scratch.rcSeeds[i * SEED_LEN];
+                          memcpy(seed, scratch.rc.data(), tail.size());
+                          reverse.push_back((uint64_t)seedKey(string_view(seed, tail.size())) << 32 | i);
+                      });
+    searchSortedSeeds(idx, reverse, scratch.seedTmp, scratch.seedLane, group,
+                      [&](int i) { return string_view(&scratch.rcSeeds[i * SEED_LEN], min<size_t>(getRead(i).size(), SEED_LEN)); },
+                      [&](int i, const pair<Pos, Pos>& range, uint64_t perSeed) {
+                          profileSeedRange(scratch.prof, range, perSeed);
+                          ProfileTimer timer;
+                          alignReverse(idx, getRead(i), scratch, opt, &range, res[i]);
+                          readNs[i] += perSeed + timer.ns();
+                      });
+
+    for (size_t i = 0; i < count; ++i) {
+        finishRead(res[i], scratch, readNs[i]);
+        if (!cached[i] && keys[i].len) opt.cache->insert(keys[i], res[i]);
+        emit(i, res[i]);
+    }
+}
+
+// read 묶음 하나를 정렬하여 read 순서대로 emit(i, 결과) (getRead(i): 묶음 안 i번째 read)
+// 단일 접두사 경로이고 이진 탐색을 쓰는 경우 opt.searchBatch개씩 첫 시드를 묶음 이진 탐색으로 먼저 찾고,
+// 역방향이 필요한 read들의 역상보 첫 시드(= read 끝 SEED_LEN 염기의 역상보)도 다시 한 묶음으로 찾음
+// read 캐시를 쓰면 캐시에 있는 read는 검색 없이 결과를 복사하고, 나머지만 정렬한 뒤 캐시에 넣음
+template <class GetRead, class Emit>
+void alignBlockEach(const SAIndex& idx, size_t count, GetRead&& getRead, AlignScratch& scratch, const AlignOptions& opt,
+                    Emit&& emit) {
+    int group = (opt.searchBatch > 1 && !opt.multiSeed && !opt.spacedSeeds && batchSearchable(idx)) ? opt.searchBatch : 0;
+    string_view seeds[MAX_SEARCH_BATCH];
+    pair<Pos, Pos> ranges[MAX_SEARCH_BATCH];
+    AlignResult res[MAX_SEARCH_BATCH];
+    int revReads[MAX_SEARCH_BATCH];
+    char rcSeeds[MAX_SEARCH_BATCH][SEED_LEN];
+    uint64_t readNs[MAX_SEARCH_BATCH];  // read별 정렬 시간 (묶음 검색 시간은 read 수로 나눠 더함, 계측용)
+    CacheKey keys[MAX_SEARCH_BATCH];
+    bool cached[MAX_SEARCH_BATCH];
+    int missReads[MAX_SEARCH_BATCH];    // 캐시에 없어 정렬할 read
+    if (group > 0 && opt.sortSeeds) {
+        alignBlockSorted(idx, count, getRead, scratch, opt, group, emit);
+        return;
+    }
+
+    for (size_t g = 0; g < count; g += max(group, 1)) {
+        if (group == 0) {
+            res[0] = alignCached(idx, getRead(g), scratch, opt);
+            emit(g, res[0]);
+            continue;
+        }
+        int n = min<size_t>(group, count - g), nmiss = 0;
+        for (int k = 0; k < n; ++k) {
+            ProfileTimer timer;
+            cached[k] = findCached(opt, getRead(g + k), keys[k], res[k], scratch.stats);
+            readNs[k] = timer.ns();
+            if (cached[k]) continue;
+            seeds[nmiss] = getRead(g + k).substr(0, SEED_LEN);
+            missReads[nmiss++] = k;
+        }
+        ProfileTimer searchTimer;
+        findPrefixRangeBatch(idx.reference, idx.sa, seeds, nmiss, ranges);
+        uint64_t perSeed = nmiss ? searchTimer.ns() / nmiss : 0;
+        for (int m = 0; m < nmiss; ++m) profileSeedRange(scratch.prof, ranges[m], perSeed);
+        int nrev = 0;
+        for (int m = 0; m < nmiss; ++m) {
+            int k = missReads[m];
+            string_view read = getRead(g + k);
+            ProfileTimer timer;
+            res[k] = alignStrand(idx, read, scratch, opt, &ranges[m]);
+            readNs[k] += perSeed + timer.ns();
+            if (!needReverse(res[k], opt)) continue;
+            string_view tail = read.substr(read.size() - min<size_t>(read.size(), SEED_LEN));
+            reverseComplement(tail, scratch.rc);
+            memcpy(rcSeeds[nrev], scratch.rc.data(), tail.size());
+            seeds[nrev] = string_view(rcSeeds[nrev], tail.size());
+            revReads[nrev++] = k;
+        }
+        searchTimer = ProfileTimer();
+        findPrefixRangeBatch(idx.reference, idx.sa, seeds, nrev, ranges);
+        perSeed = nrev ? searchTimer.ns() / nrev : 0;
+        for (int r = 0; r < nrev; ++r) {
+            profileSeedRange(scratch.prof, ranges[r], perSeed);
+            ProfileTimer timer;
+            alignReverse(idx, getRead(g + revReads[r]), scratch, opt, &ranges[r], res[revReads[r]]);
+            readNs[revReads[r]] += perSeed + timer.ns();
+        }
+        for (int k = 0; k < n; ++k) {
+            finishRead(res[k], scratch, readNs[k]);
+            if (!cached[k] && keys[k].len) opt.cache->insert(keys[k], res[k]);
+            emit(g + k, res[k]);
+        }
+    }
+}
+
+// read 묶음 하나를 정렬하여 결과를 out 뒤에 덧붙임 (firstIndex: 첫 read의 index)
+template <class GetRead>
+void alignBlock(const SAIndex& idx, size_t firstIndex, size_t count, GetRead&& getRead, AlignScratch& scratch,
+                const AlignOptions& opt, string& out) {
+    alignBlockEach(idx, count, getRead, scratch, opt, [&](size_t i, const AlignResult& res) {
+        formatResult(out, firstIndex + i, getRead(i), res, idx.layout, opt.format);
+    });
+}
+
+void printAlignStats(const AlignStats& stats, const AlignOptions& opt) {
+    cout << "매칭된 read: " << stats.mapped << " / " << stats.reads;
+    if (PROFILE_ENABLED && (opt.multiSeed || opt.spacedSeeds))
+        cout << " (단일 접두사 경로 대비 추가로 찾은 read: " << stats.recovered << ")";
+    cout << "\n";
+    cout << "  정방향(+): " << stats.forwardHits << ", 역방향(-): " << stats.reverseHits << "\n";
+    cout << "  multi-mapped (MAPQ 0): " << stats.multiMapped << ", 후보 상한에 걸린 read: " << stats.truncated << "\n";
+    if (opt.cache)
+        cout << "  read 캐시: 조회 " << stats.cacheLookups << ", 적중 " << stats.cacheHits << " ("
+             << (stats.cacheLookups ? 100.0 * stats.cacheHits / stats.cacheLookups : 0) << "%), 항목 " << opt.cache->size()
+             << " / " << opt.cache->maxEntries() << ", 교체 " << opt.cache->evictions() << "\n";
+    if (opt.editDistance)
+        cout << "  편집 거리 검증: 후보 " << stats.editVerified << "개, Hamming보다 나아진 read " << stats.editRescued << "개\n";
+    for (int p = 0; p < SPACED_SEED_COUNT; ++p)
+        if (opt.spacedSeeds >> p & 1) cout << "  spaced seed " << SPACED_SEED_PATTERNS[p] << ": 후보 " << stats.spacedHits[p] << "개\n";
+    if (stats.pairs > 0)
+        cout << "  쌍: " << stats.pairs << ", proper pair: " << stats.properPairs << " ("
+             << 100.0 * stats.properPairs / stats.pairs << "%), mate rescue: 시도 " << stats.rescueTried << ", 성공 "
+             << stats.rescued << " (" << (stats.rescueTried ? 100.0 * stats.rescued / stats.rescueTried : 0) << "%)\n";
+}
+
+// 모든 read를 정렬하여 write(buf)로 기록
+// read를 blockSize개씩 묶어 스레드마다 자기 버퍼에 결과를 만들고, ordered 구간에서 묶음 순서대로 한 번에 씀
+// → read마다 잠금을 잡지 않고, 출력은 스레드 수와 무관하게 read index 순서로 항상 같음
+template <class Write>
+AlignStats alignReads(const SAIndex& idx, const vector<string>& reads, Write&& write, const AlignOptions& opt,
+                      int threads, size_t blockSize) {
+    AlignStats total;
+    // read 수가 적으면 스레드마다 묶음이 여러 개 돌아가도록 묶음 크기를 줄임
+    blockSize = max<size_t>(1, min(blockSize, reads.size() / (8 * threads)));
+    int blocks = (reads.size() + blockSize - 1) / blockSize;
+    atomic<int> nextThread(0);
+
+    #pragma omp parallel num_threads(threads)
+    {
+        LocalIndex local(idx, opt, nextThread++);
+        AlignScratch scratch;
+        string buf;
+
+        #pragma omp for schedule(dynamic) ordered
+        for (int b = 0; b < blocks; ++b) {
+            buf.clear();
+            size_t first = b * blockSize, end = min(reads.size(), first + blockSize);
+            alignBlock(local.get(), first, end - first, [&](size_t i) { return string_view(reads[first + i]); }, scratch, opt,
+                       buf);
+
+            #pragma omp ordered
+            write(string_view(buf));
+        }
+
+        #pragma omp critical
+        total += scratch.stats;
+    }
+    return total;
+}
+
+// 스레드 수를 1, 2, 4, ... maxThreads(최대 64)로 바꿔 가며 정렬 처리량 비교
+// 각 실행의 출력이 1스레드 출력과 바이트 단위로 같은지도 확인하고, 마지막 출력을 write로 기록
+template <class Write>
+AlignStats threadScan(const SAIndex& idx, const vector<string>& reads, Write&& write, const AlignOptions& opt,
+                      int maxThreads, size_t blockSize) {
+    AlignStats stats;
+    string reference;
+    double baseRate = 0;
+    cout << "스레드 수별 정렬 처리량:\n";
+    for (int t = 1; t <= min(maxThreads, 64); t *= 2) {
+        string sout;
+        if (opt.cache) opt.cache->clear();  // 이전 실행의 결과가 남아 있으면 처리량을 비교할 수 없음
+        auto t1 = high_resolution_clock::now();
+        stats = alignReads(idx, reads, [&](string_view buf) { sout += buf; }, opt, t, blockSize);
+        auto t2 = high_resolution_clock::now();
+        double sec = chrono::duration_cast<chrono::duration<double>>(t2 - t1).count();
+        double rate = sec > 0 ? reads.size() / sec : 0;
+        if (t == 1) {
+            baseRate = rate;
+            reference = sout;
+        }
+        cout << "  " << t << " 스레드: " << rate << " reads/s (x" << (baseRate > 0 ? rate / baseRate : 0) << ")"
+             << (sout == reference ? "" : "  ⚠ 출력이 1스레드와 다름") << "\n";
+        if (t * 2 > min(maxThreads, 64)) write(string_view(sout));
+    }
+    return stats;
+}
+
+// ✅ paired-end 정렬
+// 두 mate를 각각 양쪽 가닥에서 정렬한 뒤, 한 mate만 확실히 매칭되면 (anchor) 다른 mate를 anchor가 정하는
+// reference 구간 [anchor ± insert size 허용 구간]에서만 mismatch 커널로 다시 찾음 (mate rescue, 시드 검색 없음)
+// 라이브러리 방향은 FR: 정방향 mate가 왼쪽, 역방향 mate가 오른쪽, insert = 역방향 mate 끝 - 정방향 mate 시작
+const int PAIR_ANCHOR_MAPQ = 20;         // 이 이상이면 anchor, 두 mate 모두 이 이상이면 insert size 추정 표본
+const uint64_t PAIR_MIN_SAMPLES = 100;   // 표본이 이보다 적으면 [1, maxInsert]를 허용 구간으로 씀
+const size_t PAIR_ESTIMATE_STEP = 1024;  // 허용 구간을 다시 계산하는 간격 (쌍 수)
+
+// insert size 분포 온라인 추정: 확실히 매칭된 쌍의 insert를 히스토그램에 모아 두고
+// 허용 구간 = [Q1 - 3·IQR, Q3 + 3·IQR] (정규 분포면 평균 ± 약 4.7σ, 키메라 쌍 같은 이상치에 둔감)
+class InsertSizeEstimator {
+    vector<uint64_t> hist;  // insert → 쌍 수 (1 ~ maxInsert)
+    uint64_t samples = 0;
+    long long lo, hi;
+
+    long long quantile(double q) const {
+        uint64_t want = q * (samples - 1), seen = 0;
+        for (size_t x = 0; x < hist.size(); ++x)
+            if ((seen += hist[x]) > want) return x;
+        return hist.size() - 1;
+    }
+
+public:
+    explicit InsertSizeEstimator(long long maxInsert) : hist(maxInsert + 1, 0), lo(1), hi(maxInsert) {}
+
+    void add(long long insert) {
+        if (insert <= 0 || insert >= (long long)hist.size()) return;
+        hist[insert]++;
+        samples++;
+    }
+    // 지금까지 모은 표본으로 허용 구간 갱신 (표본이 모자라면 그대로)
+    void update() {
+        if (samples < PAIR_MIN_SAMPLES) return;
+        long long q1 = quantile(0.25), q3 = quantile(0.75);
+        lo = max(1LL, q1 - 3 * (q3 - q1));
+        hi = min((long long)hist.size() - 1, q3 + 3 * (q3 - q1));
+    }
+    bool accepts(long long insert) const { return insert >= lo && insert <= hi; }
+    long long low() const { return lo; }
+    long long high() const { return hi; }
+    uint64_t count() const { return samples; }
+    long long median() const { return samples ? quantile(0.5) : 0; }
+};
+
+// 쌍 하나의 결과 (rescued: rescue로 결과가 바뀐 mate 번호, 없으면 -1)
+struct PairResult {
+    AlignResult mate[2];
+    long long insert = 0;   // FR 방향으로 같은 contig에 매칭되었을 때의 insert size (아니면 0)
+    bool proper = false;    // insert가 허용 구간 안
+    int rescued = -1;
+};
+
+bool confidentMate(const AlignResult& res) { return res.pos != -1 && res.mapq >= PAIR_ANCHOR_MAPQ; }
+
+// FR 방향으로 같은 contig에 매칭된 쌍의 insert size (아니면 0)
+long long pairInsert(const AlignResult& a, size_t lenA, const AlignResult& b, size_t lenB, const RefLayout& layout) {
+    if (a.pos == -1 || b.pos == -1 || a.reverse == b.reverse) return 0;
+    if (layout.contigOf(a.pos) != layout.contigOf(b.pos)) return 0;
+    const AlignResult& fwd = a.reverse ? b : a;
+    const AlignResult& rev = a.reverse ? a : b;
+    long long insert = (long long)rev.pos + (a.reverse ? lenA : lenB) - fwd.pos;
+    return max(insert, 0LL);
+}
+
+// anchor가 정하는 구간에서 mate를 mismatch 커널로 찾음
+// (anchor가 정방향이면 mate는 역방향으로 오른쪽에, 역방향이면 정방향으로 왼쪽에 있어야 함)
+// 매칭이 없던 mate는 구간 안 best로, multi-mapped mate는 구간 안에서 유일하고 원래보다 나쁘지 않을 때만 교체하고 true
+// 유일성은 구간 안에서만 본 것이므로 (게놈 전체에 같은 best가 있을 수 있음) MAPQ는 anchor 기준값 PAIR_ANCHOR_MAPQ 이하로 제한
+bool rescueMate(const SAIndex& idx, const AlignResult& anchor, size_t anchorLen, string_view read, AlignResult& mate,
+                const InsertSizeEstimator& insert, AlignScratch& scratch, const AlignOptions& opt) {
+    const PackedRef& reference = idx.reference;
+    long long len = read.size(), first, last;  // mate 시작 위치 범위
+    bool reverse = !anchor.reverse;
+    if (!anchor.reverse) {
+        first = anchor.pos + insert.low() - len;
+        last = anchor.pos + insert.high() - len;
+    } else {
+        first = anchor.pos + (long long)anchorLen - insert.high();
+        last = anchor.pos + (long long)anchorLen - insert.low();
+    }
+    if (!idx.layout.contigs.empty()) {
+        const Contig& c = idx.layout.contigs[idx.layout.contigOf(anchor.pos)];
+        first = max(first, (long long)c.start);
+        last = min(last, (long long)(c.start + c.length) - len);
+    }
+    first = max(first, 0LL);
+    last = min(last, (long long)reference.size() - len);
+    if (first > last) return false;
+
+    if (reverse) reverseComplement(read, scratch.rc);
+    scratch.packed.assign(reverse ? string_view(scratch.rc) : read);
+    AlignResult win;
+    for (long long q = first; q <= last; ++q) {
+        if (!idx.layout.inside(q, len)) continue;
+        scratch.prof.add(Profile::Verifications);
+        if (updateBest(win, q, opt.countMismatch(reference, q, scratch.packed, candidateLimit(win)))) break;
+    }
+    if (win.pos == -1 || win.mismatch > MAX_ERROR) return false;
+    bool unique = win.second > win.mismatch;
+    if (mate.pos != -1 && !(unique && win.mismatch <= mate.mismatch)) return false;
+
+    win.reverse = reverse;
+    win.mapq = min(mappingQuality(win), PAIR_ANCHOR_MAPQ);
+    // 독립 정렬 결과로 센 통계를 새 결과로 바꿈
+    AlignStats& stats = scratch.stats;
+    if (mate.pos == -1) stats.mapped++;
+    else {
+        stats.multiMapped--;
+        (mate.reverse ? stats.reverseHits : stats.forwardHits)--;
+    }
+    (win.reverse ? stats.reverseHits : stats.forwardHits)++;
+    stats.multiMapped += !unique;
+    mate = win;
+    return true;
+}
+
+// 쌍 하나를 형식에 맞춰 out 뒤에 덧붙임
+// text: "pair index: i -> mate1: <매칭>[, rescued]; mate2: <매칭>[, rescued][; insert: N[, proper pair]]"
+// binary: mate별 OutputRecord 두 개 (readIndex = 쌍 index), SAM: mate별 레코드 두 줄 (FLAG 0x1/0x2/0x40/0x80, RNEXT/PNEXT/TLEN)
+void formatPair(string& out, size_t index, string_view read1, string_view read2, const PairResult& p, const RefLayout& layout,
+                OutputFormat format) {
+    string_view reads[2] = {read1, read2};
+    if (format == OutputFormat::Text) {
+        out += "pair index: ";
+        appendInt(out, index);
+        for (int m = 0; m < 2; ++m) {
+            out += m ? "; mate2: " : " -> mate1: ";
+            formatMatch(out, p.mate[m], layout);
+            if (p.rescued == m) out += ", rescued";
+        }
+        if (p.insert > 0) {
+            out += "; insert: ";
+            appendInt(out, p.insert);
+            if (p.proper) out += ", proper pair";
+        }
+        out += '\n';
+        return;
+    }
+    for (int m = 0; m < 2; ++m) {
+        if (format == OutputFormat::Binary) {
+            formatBinary(out, index, p.mate[m], layout,
+                         (m ? OUT_MATE2 : 0) | (p.proper ? OUT_PROPER_PAIR : 0) | (p.rescued == m ? OUT_RESCUED : 0));
+        } else {
+            long long tlen = p.insert > 0 ? (p.mate[m].reverse ? -p.insert : p.insert) : 0;
+            SamMate mate{0x1 | (p.proper ? 0x2 : 0) | (m ? 0x80 : 0x40), &p.mate[1 - m], tlen};
+            formatSAM(out, index, reads[m], p.mate[m], layout, &mate);
+        }
+    }
+}
+
+// 쌍 i = (reads1[i], reads2[i])를 모두 정렬하여 write(buf)로 기록
+// 독립 정렬은 alignReads처럼 blockSize개 쌍씩 병렬로 하고, insert size 추정·rescue·출력은 ordered 구간에서 쌍 순서대로 함
+// → 허용 구간은 PAIR_ESTIMATE_STEP개 쌍마다 그 앞 쌍들의 표본으로만 갱신되므로 결과는 스레드 수, 묶음 크기와 무관
+template <class Write>
+AlignStats alignPairs(const SAIndex& idx, const vector<string>& reads1, const vector<string>& reads2, Write&& write,
+                      const AlignOptions& opt, int threads, size_t blockSize, InsertSizeEstimator& insert) {
+    AlignStats total;
+    blockSize = max<size_t>(1, min(blockSize, reads1.size() / (8 * threads)));
+    int blocks = (reads1.size() + blockSize - 1) / blockSize;
+    atomic<int> nextThread(0);
+
+    #pragma omp parallel num_threads(threads)
+    {
+        LocalIndex local(idx, opt, nextThread++);
+        const SAIndex& index = local.get();
+        AlignScratch scratch;
+        vector<PairResult> pairs;
+        string buf;
+
+        #pragma omp for schedule(dynamic) ordered
+        for (int b = 0; b < blocks; ++b) {
+            size_t first = b * blockSize, end = min(reads1.size(), first + blockSize);
+            pairs.assign(end - first, PairResult());
+            // mate마다 묶음 전체를 단일 read와 같은 경로(묶음 이진 탐색, --sort-seeds)로 정렬
+            for (int m = 0; m < 2; ++m) {
+                const vector<string>& reads = m ? reads2 : reads1;
+                alignBlockEach(index, end - first, [&](size_t i) { return string_view(reads[first + i]); }, scratch, opt,
+                               [&](size_t i, const AlignResult& res) { pairs[i].mate[m] = res; });
+            }
+
+            #pragma omp ordered
+            {
+                buf.clear();
+                for (size_t i = first; i < end; ++i) {
+                    if (i % PAIR_ESTIMATE_STEP == 0) insert.update();
+                    PairResult& p = pairs[i - first];
+                    size_t len[2] = {reads1[i].size(), reads2[i].size()};
+                    // 추정 표본은 rescue 전 독립 정렬 결과로 두 mate 모두 확실한 쌍만
+                    long long sample = pairInsert(p.mate[0], len[0], p.mate[1], len[1], index.layout);
+                    bool confident = confidentMate(p.mate[0]) && confidentMate(p.mate[1]);
+                    for (int m = 0; m < 2; ++m) {
+                        AlignResult& mate = p.mate[1 - m];
+                        if (!confidentMate(p.mate[m]) || (mate.pos != -1 && mate.second > mate.mismatch)) continue;
+                        scratch.stats.rescueTried++;
+                        if (rescueMate(index, p.mate[m], len[m], m ? reads1[i] : reads2[i], mate, insert, scratch, opt)) {
+                            p.rescued = 1 - m;
+                            scratch.stats.rescued++;
+                        }
+                    }
+                    p.insert = pairInsert(p.mate[0], len[0], p.mate[1], len[1], index.layout);
+                    p.proper = p.insert > 0 && insert.accepts(p.insert);
+                    if (confident) insert.add(sample);
+                    scratch.stats.pairs++;
+                    scratch.stats.properPairs += p.proper;
+                    formatPair(buf, i, reads1[i], reads2[i], p, index.layout, opt.format);
+                }
+                write(string_view(buf));
+            }
+        }
+
+        #pragma omp critical
+        total += scratch.stats;
+    }
+    return total;
+}
+
+// 고정 크기 read 묶음: 모든 서열을 버퍼 하나에 이어 붙이고 offsets로 경계 표시 (read마다 할당하지 않음)
+struct ReadBatch {
+    uint64_t seq = 0;          // 묶음 순번 (출력 순서 복원용)
+    size_t firstIndex = 0;     // 첫 read의 전체 read index
+    string data;
+    vector<uint32_t> offsets;  // read i = data[offsets[i], offsets[i + 1])
+    string out;                // 정렬 결과 (출력 형식대로)
+
+    size_t size() const { return offsets.size() - 1; }
+    string_view read(size_t i) const { return string_view(data).substr(offsets[i], offsets[i + 1] - offsets[i]); }
+    void clear() {
+        data.clear();
+        offsets.assign(1, 0);
+        out.clear();
+    }
+};
+
+// 용량이 정해진 스레드 안전 큐 (가득 차면 push가, 비면 pop이 대기)
+template <class T>
+class BoundedQueue {
+    mutex m;
+    condition_variable notEmpty, notFull;
+    deque<T> q;
+    size_t cap;
+    bool closed = false;
+
+public:
+    explicit BoundedQueue(size_t capacity) : cap(capacity) {}
+
+    void push(T v) {
+        unique_lock<mutex> lk(m);
+        notFull.wait(lk, [&] { return q.size() < cap; });
+        q.push_back(move(v));
+        notEmpty.notify_one();
+    }
+
+    // 닫힌 뒤 큐가 비면 false
+    bool pop(T& v) {
+        unique_lock<mutex> lk(m);
+        notEmpty.wait(lk, [&] { return !q.empty() || closed; });
+        if (q.empty()) return false;
+        v = move(q.front());
+        q.pop_front();
+        notFull.notify_one();
+        return true;
+    }
+
+    void close() {
+        lock_guard<mutex> lk(m);
+        closed = true;
+        notEmpty.notify_all();
+    }
+};
+
+// 스트리밍 정렬: reader 스레드 → (작업 큐) → worker 스레드들 → (완료 큐) → writer(현재 스레드)
+// 묶음은 고정 개수의 풀에서 돌려 쓰므로 read 수와 무관하게 최대 메모리는 (풀 크기 × 묶음 크기)로 고정됨
+// writer는 순번대로 묶음을 write(buf)로 기록하므로 출력은 read index 순서
+template <class Write>
+AlignStats alignStream(const SAIndex& idx, const string& readsFile, Write&& write, const AlignOptions& opt,
+                       int threads, size_t batchSize) {
+    AlignStats total;
+    ReadParser parser(readsFile);
+    if (!parser.isOpen()) {
+        cerr << "read 파일을 열 수 없음: " << readsFile << "\n";
+        return total;
+    }
+
+    size_t poolSize = 2 * threads + 2;
+    vector<unique_ptr<ReadBatch>> pool;
+    BoundedQueue<ReadBatch*> freeQ(poolSize), workQ(poolSize), doneQ(poolSize);
+    for (size_t b = 0; b < poolSize; ++b) {
+        pool.push_back(make_unique<ReadBatch>());
+        freeQ.push(pool.back().get());
+    }
+
+    thread reader([&] {
+        uint64_t seq = 0;
+        size_t index = 0;
+        ReadBatch* batch;
+        while (freeQ.pop(batch)) {
+            batch->clear();
+            while (batch->size() < batchSize && parser.next(batch->data)) batch->offsets.push_back(batch->data.size());
+            if (batch->size() == 0) break;
+            batch->seq = seq++;
+            batch->firstIndex = index;
+            index += batch->size();
+            workQ.push(batch);
+        }
+        workQ.close();
+    });
+
+    vector<thread> workers;
+    vector<AlignStats> workerStats(threads);
+    atomic<int> running(threads);
+    for (int t = 0; t < threads; ++t) {
+        workers.emplace_back([&, t] {
+            LocalIndex local(idx, opt, t);
+            AlignScratch scratch;
+            ReadBatch* batch;
+            while (workQ.pop(batch)) {
+                alignBlock(local.get(), batch->firstIndex, batch->size(), [&](size_t i) { return batch->read(i); }, scratch, opt,
+                           batch->out);
+                doneQ.push(batch);
+            }
+            workerStats[t] = scratch.stats;
+            if (--running == 0) doneQ.close();
+        });
+    }
+
+    // 순번이 앞선 묶음이 끝날 때까지 먼저 끝난 묶음을 보관 (최대 풀 크기만큼)
+    vector<ReadBatch*> pending(poolSize, nullptr);
+    uint64_t nextSeq = 0;
+    ReadBatch* batch;
+    while (doneQ.pop(batch)) {
+        pending[batch->seq % poolSize] = batch;
+        while (ReadBatch* ready = pending[nextSeq % poolSize]) {
+            if (ready->seq != nextSeq) break;
+            write(string_view(ready->out));
+            pending[nextSeq % poolSize] = nullptr;
+            ++nextSeq;
+            freeQ.push(ready);
+        }
+    }
+    freeQ.close();
+
+    reader.join();
+    for (auto& w : workers) w.join();
+    for (auto& st : workerStats) total += st;
+    return total;
+}
+
+// ✅ 상주 서버 (serve 모드)
+// 인덱스를 한 번만 구축/로드하고 정렬 스레드 풀을 띄워 둔 채, Unix 도메인 소켓으로 read 묶음을 받아 결과를 돌려줌
+// 프로토콜 (리틀 엔디언, 요청 하나에 응답 하나, 한 연결에서 여러 요청을 차례로 보낼 수 있음)
+//  요청: ServeRequest + payload (SERVE_ALIGN: [uint32 read 길이][read 서열]을 readCount번 반복)
+//  응답: ServeResponse + payload (SERVE_ALIGN: --format 형식의 결과 레코드, read index는 firstIndex부터
+//        SERVE_HEADER: 형식별 헤더, SERVE_STATS: 요청 지연 요약 텍스트, 오류: 메시지)
+// aligner_client.cpp가 같은 구조체를 쓰므로 바꾸면 함께 고쳐야 함
+const uint32_t SERVE_MAGIC = 0x51415253;  // "SRAQ"
+enum ServeRequestType : uint32_t { SERVE_ALIGN = 1, SERVE_HEADER = 2, SERVE_STATS = 3, SERVE_SHUTDOWN = 4 };
+
+struct ServeRequest {
+    uint32_t magic;
+    uint32_t type;
+    uint64_t firstIndex;
+    uint64_t readCount;
+    uint64_t payloadBytes;
+};
+
+struct ServeResponse {
+    uint32_t magic;
+    uint32_t status;  // 0: 성공, 1: 오류
+    uint64_t readCount;
+    uint64_t payloadBytes;
+};
+
+const uint64_t SERVE_MAX_PAYLOAD = 1ULL << 30;
+const size_t SERVE_CHUNK = 256;  // 풀의 스레드 하나가 한 번에 맡는 read 수
+
+atomic<bool> serveStop(false);  // SIGINT/SIGTERM 또는 SERVE_SHUTDOWN 요청
+
+bool readFull(int fd, void* buf, size_t n) {
+    char* p = static_cast<char*>(buf);
+    while (n > 0) {
+        ssize_t r = ::read(fd, p, n);
+        if (r < 0 && errno == EINTR) continue;
+        if (r <= 0) return false;
+        p += r;
+        n -= r;
+    }
+    return true;
+}
+
+// 상대가 먼저 끊어도 SIGPIPE로 서버가 죽지 않도록 send(MSG_NOSIGNAL) 사용
+bool sendFull(int fd, string_view buf) {
+    while (!buf.empty()) {
+        ssize_t n = ::send(fd, buf.data(), buf.size(), MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        buf.remove_prefix(n);
+    }
+    return true;
+}
+
+bool sendResponse(int fd, uint32_t status, uint64_t readCount, string_view payload) {
+    ServeResponse resp{SERVE_MAGIC, status, readCount, payload.size()};
+    return sendFull(fd, string_view(reinterpret_cast<const char*>(&resp), sizeof(resp))) && sendFull(fd, payload);
+}
+
+// 상주 정렬 스레드 풀: 스레드마다 AlignScratch를 계속 재사용하며 작업 큐의 read 묶음을 정렬
+// 작업은 그 스레드가 읽을 인덱스(NUMA 복제본이 있으면 스레드 노드의 복제본)를 함께 받음
+class AlignPool {
+    BoundedQueue<function<void(AlignScratch&, const SAIndex&)>> tasks;
+    vector<thread> threads;
+    mutex statsMutex;
+    AlignStats total;
+
+public:
+    AlignPool(int n, const SAIndex& idx, const AlignOptions& opt) : tasks(4 * n) {
+        for (int t = 0; t < n; ++t) {
+            threads.emplace_back([this, &idx, &opt, t] {
+                LocalIndex local(idx, opt, t);
+                AlignScratch scratch;
+                function<void(AlignScratch&, const SAIndex&)> task;
+                while (tasks.pop(task)) task(scratch, local.get());
+                lock_guard<mutex> lk(statsMutex);
+                total += scratch.stats;
+            });
+        }
+    }
+    ~AlignPool() { stop(); }
+
+    void submit(function<void(AlignScratch&, const SAIndex&)> task) { tasks.push(move(task)); }
+
+    // 남은 작업을 마치고 스레드를 모두 종료한 뒤 누적 통계 반환
+    AlignStats stop() {
+        tasks.close();
+        for (auto& t : threads) t.join();
+        threads.clear();
+        return total;
+    }
+};
+
+// read 묶음을 SERVE_CHUNK개씩 나눠 풀에 맡기고, 모두 끝나면 read index 순서대로 out에 이어 붙임
+void alignRequest(AlignPool& pool, const AlignOptions& opt, const vector<string_view>& reads,
+                  size_t firstIndex, string& out) {
+    size_t chunks = (reads.size() + SERVE_CHUNK - 1) / SERVE_CHUNK;
+    vector<string> outs(chunks);
+    mutex m;
+    condition_variable done;
+    size_t remaining = chunks;
+    for (size_t c = 0; c < chunks; ++c) {
+        pool.submit([&, c](AlignScratch& scratch, const SAIndex& idx) {
+            size_t first = c * SERVE_CHUNK, count = min(SERVE_CHUNK, reads.size() - first);
+            alignBlock(idx, firstIndex + first, count, [&](size_t i) { return reads[first + i]; }, scratch, opt, outs[c]);
+            lock_guard<mutex> lk(m);
+            if (--remaining == 0) done.notify_one();
+        });
+    }
+    unique_lock<mutex> lk(m);
+    done.wait(lk, [&] { return remaining == 0; });
+    for (const string& s : outs) out += s;
+}
+
+// SERVE_ALIGN payload를 read 목록으로 나눔 (payload를 그대로 가리키는 view, 형식이 맞지 않으면 false)
+// read 파일의 빈 줄처럼 길이 0인 read는 받지 않음
+bool parseServeReads(string_view payload, uint64_t readCount, vector<string_view>& reads) {
+    reads.clear();
+    for (uint64_t i = 0; i < readCount; ++i) {
+        uint32_t len;
+        if (payload.size() < sizeof(len)) return false;
+        memcpy(&len, payload.data(), sizeof(len));
+        payload.remove_prefix(sizeof(len));
+        if (len == 0 || payload.size() < len) return false;
+        reads.push_back(payload.substr(0, len));
+        payload.remove_prefix(len);
+    }
+    return payload.empty();
+}
+
+// 요청별 지연 시간 기록 (요청 헤더 수신 ~ 응답 전송 완료)
+class LatencyLog {
+    mutable mutex m;
+    vector<uint64_t> ns;
+    uint64_t reads = 0;
+
+public:
+    void add(uint64_t t, size_t n) {
+        lock_guard<mutex> lk(m);
+        ns.push_back(t);
+        reads += n;
+    }
+
+    string summary() const {
+        lock_guard<mutex> lk(m);
+        ostringstream os;
+        os << "정렬 요청 " << ns.size() << "개 (read " << reads << "개)";
+        if (ns.empty()) return os.str();
+        vector<uint64_t> sorted(ns);
+        sort(sorted.begin(), sorted.end());
+        auto ms = [&](double q) { return sorted[min(sorted.size() - 1, size_t(q * sorted.size()))] / 1e6; };
+        os << ", 지연 p50 " << ms(0.5) << " ms, p99 " << ms(0.99) << " ms, 최대 " << sorted.back() / 1e6 << " ms";
+        return os.str();
+    }
+};
+
+struct ServeState {
+    const SAIndex& idx;
+    const AlignOptions& opt;
+    AlignPool& pool;
+    LatencyLog latency;
+    mutex m;
+    condition_variable idle;
+    vector<int> conns;  // 열린 연결 (종료 시 shutdown으로 대기 중인 read를 깨움)
+};
+
+// 연결 하나의 요청을 차례로 처리 (연결마다 스레드 하나, 정렬은 공유 풀에서)
+void serveConnection(ServeState& st, int fd) {
+    string payload, out;
+    vector<string_view> reads;
+    ServeRequest req;
+    while (readFull(fd, &req, sizeof(req))) {
+        auto t1 = high_resolution_clock::now();
+        if (req.magic != SERVE_MAGIC || req.payloadBytes > SERVE_MAX_PAYLOAD) {
+            sendResponse(fd, 1, 0, "잘못된 요청 헤더");
+            break;
+        }
+        payload.resize(req.payloadBytes);
+        if (!readFull(fd, payload.data(), payload.size())) break;
+        out.clear();
+        bool ok = true;
+        if (req.type == SERVE_ALIGN) {
+            if (!parseServeReads(payload, req.readCount, reads)) {
+                sendResponse(fd, 1, 0, "read 목록 형식 오류");
+                break;
+            }
+            alignRequest(st.pool, st.opt, reads, req.firstIndex, out);
+            ok = sendResponse(fd, 0, reads.size(), out);
+            st.latency.add(duration_cast<nanoseconds>(high_resolution_clock::now() - t1).count(), reads.size());
+        } else if (req.type == SERVE_HEADER) {
+            formatHeader(out, st.idx.layout, st.opt.format);
+            ok = sendResponse(fd, 0, 0, out);
+        } else if (req.type == SERVE_STATS) {
+            ok = sendResponse(fd, 0, 0, st.latency.summary());
+        } else if (req.type == SERVE_SHUTDOWN) {
+            serveStop = true;
+            sendResponse(fd, 0, 0, "");
+            break;
+        } else {
+            sendResponse(fd, 1, 0, "알 수 없는 요청 종류");
+            break;
+        }
+        if (!ok) break;
+    }
+}
+
+// socketPath에서 연결을 받아 요청을 처리하고, 종료 요청이나 SIGINT/SIGTERM을 받으면 정렬 누적 통계를 stats에 기록
+// 소켓을 열지 못하면 false
+bool serveRequests(const SAIndex& idx, const AlignOptions& opt, const string& socketPath, int threads, AlignStats& stats) {
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    if (socketPath.size() >= sizeof(addr.sun_path)) {
+        cerr << "소켓 경로가 너무 김: " << socketPath << "\n";
+        return false;
+    }
+    memcpy(addr.sun_path, socketPath.c_str(), socketPath.size() + 1);
+    int lfd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    ::unlink(socketPath.c_str());  // 이전 실행이 남긴 소켓 파일
+    if (lfd < 0 || ::bind(lfd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 || ::listen(lfd, 64) != 0) {
+        cerr << "소켓을 열 수 없음: " << socketPath << " (" << strerror(errno) << ")\n";
+        if (lfd >= 0) ::close(lfd);
+        return false;
+    }
+
+    serveStop = false;
+    auto onSignal = [](int) { serveStop = true; };
+    signal(SIGINT, onSignal);
+    signal(SIGTERM, onSignal);
+
+    AlignPool pool(threads, idx, opt);
+    ServeState st{idx, opt, pool, {}, {}, {}, {}};
+    cout << "서버 대기 중: " << socketPath << " (정렬 스레드 " << threads << "개)" << endl;
+
+    // 종료 신호를 주기적으로 확인하도록 accept 전에 poll로 기다림
+    while (!serveStop) {
+        pollfd p{lfd, POLLIN, 0};
+        if (::poll(&p, 1, 200) <= 0) continue;
+        int fd = ::accept(lfd, nullptr, nullptr);
+        if (fd < 0) continue;
+        lock_guard<mutex> lk(st.m);
+        st.conns.push_back(fd);
+        thread([&st, fd] {
+            serveConnection(st, fd);
+            lock_guard<mutex> lk(st.m);
+            st.conns.erase(find(st.conns.begin(), st.conns.end(), fd));
+            ::close(fd);
+            st.idle.notify_all();
+        }).detach();
+    }
+    ::close(lfd);
+    ::unlink(socketPath.c_str());
+
+    {
+        unique_lock<mutex> lk(st.m);
+        for (int fd : st.conns) ::shutdown(fd, SHUT_RDWR);
+        st.idle.wait(lk, [&] { return st.conns.empty(); });
+    }
+    signal(SIGINT, SIG_DFL);
+    signal(SIGTERM, SIG_DFL);
+    cout << "서버 종료: " << st.latency.summary() << "\n";
+    stats = pool.stop();
+    return true;
+}
+
+// 프로세스 최대 메모리 사용량 (MB)
+double peakRSSMB() {
+    struct rusage ru;
+    getrusage(RUSAGE_SELF, &ru);
+#if defined(__APPLE__)
+    return ru.ru_maxrss / 1048576.0; // macOS는 바이트 단위
+#else
+    return ru.ru_maxrss / 1024.0;    // Linux는 KB 단위
+#endif
+}
+
+// 시드 구간 비교 (빈 구간은 삽입 위치와 무관하게 같은 결과로 취급)
+bool sameRange(pair<Pos, Pos> a, pair<Pos, Pos> b) {
+    if (a.first == a.second || b.first == b.second) return a.first == a.second && b.first == b.second;
+    return a == b;
+}
+
+// 시드 검색 방식별 read당 평균 시간 비교 (단일 스레드, 기준인 전체 이진 탐색과 결과 일치 여부도 확인)
+// 긴 시드에서의 차이도 보기 위해 SEED_LEN, 2배, 5배 길이로 각각 측정
+// 하드웨어 LLC miss 카운터 (perf_event_open, 현재 스레드의 사용자 공간만)
+// 커널 설정(perf_event_paranoid)이나 VM이 허용하지 않으면 available() = false
+class LLCMissCounter {
+    int fd = -1;
+
+public:
+    LLCMissCounter() {
+        perf_event_attr attr{};
+        attr.size = sizeof(attr);
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.config = PERF_COUNT_HW_CACHE_MISSES;
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        fd = syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+    }
+    ~LLCMissCounter() {
+        if (fd >= 0) close(fd);
+    }
+    LLCMissCounter(const LLCMissCounter&) = delete;
+    LLCMissCounter& operator=(const LLCMissCounter&) = delete;
+
+    bool available() const { return fd >= 0; }
+    void start() {
+        ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+        ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+    }
+    uint64_t stop() {
+        uint64_t count = 0;
+        ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+        if (::read(fd, &count, sizeof(count)) != sizeof(count)) return 0;
+        return count;
+    }
+};
+
+void benchSeedSearch(const SAIndex& idx, const vector<string>& reads, int searchBatch, size_t blockSize) {
+    if (reads.empty()) return;
+    LLCMissCounter llc;
+    if (!llc.available()) cout << "(LLC miss 카운터를 열 수 없어 시간만 출력: " << strerror(errno) << ")\n";
+    vector<pair<Pos, Pos>> expected(reads.size()), got(reads.size());
+    int len = SEED_LEN;
+    auto seed = [&](size_t i) { return string_view(reads[i]).substr(0, len); };
+    vector<int> batches = {8, 16, 32, MAX_SEARCH_BATCH};
+    if (searchBatch > 1 && find(batches.begin(), batches.end(), searchBatch) == batches.end()) batches.push_back(searchBatch);
+
+    // fill: out 전체를 채우는 함수
+    auto measure = [&](const string& label, vector<pair<Pos, Pos>>& out, auto&& fill) {
+        if (llc.available()) llc.start();
+        auto t1 = high_resolution_clock::now();
+        fill(out);
+        auto t2 = high_resolution_clock::now();
+        uint64_t misses = llc.available() ? llc.stop() : 0;
+        double ns = chrono::duration_cast<chrono::duration<double, nano>>(t2 - t1).count() / reads.size();
+        cout << "  " << label << ": " << ns << " ns/read";
+        if (llc.available()) cout << ", LLC miss " << double(misses) / reads.size() << "/read";
+        if (&out != &expected) {
+            size_t diff = 0;
+            for (size_t i = 0; i < reads.size(); ++i)
+                if (!sameRange(out[i], expected[i])) ++diff;
+            cout << (diff == 0 ? " (결과 일치)" : " (결과 불일치 " + to_string(diff) + "건)");
+        }
+        cout << "\n";
+    };
+    auto run = [&](const string& label, vector<pair<Pos, Pos>>& out, auto&& search) {
+        measure(label, out, [&](vector<pair<Pos, Pos>>& o) {
+            for (size_t i = 0; i < reads.size(); ++i) o[i] = search(seed(i));
+        });
+    };
+
+    for (int factor : {1, 2, 5}) {
+        len = SEED_LEN * factor;
+        cout << "[시드 검색 벤치마크] 시드 길이=" << len << ", reads=" << reads.size() << "\n";
+        bool hasSA = idx.sa.size() > 0;
+        if (hasSA)
+            run("binary search", expected, [&](string_view seed) { return findPrefixRange(idx.reference, idx.sa, idx.lcp, seed); });
+        if (idx.backend == IndexBackend::FM)
+            run("FM backward search", hasSA ? got : expected, [&](string_view seed) { return idx.fm.search(seed); });
+        if (!hasSA) continue;
+        for (int batch : batches) {
+            measure("batched binary search (B=" + to_string(batch) + (batch == searchBatch ? ", 정렬에 사용" : "") + ")", got, [&](vector<pair<Pos, Pos>>& o) {
+                string_view seeds[MAX_SEARCH_BATCH];
+                for (size_t g = 0; g < reads.size(); g += batch) {
+                    int n = min<size_t>(batch, reads.size() - g);
+                    for (int k = 0; k < n; ++k) seeds[k] = seed(g + k);
+                    findPrefixRangeBatch(idx.reference, idx.sa, seeds, n, &o[g]);
+                }
+            });
+        }
+        // 정렬 경로와 같은 방식: blockSize개 read마다 첫 시드를 radix 정렬해 찾고 원래 순서 자리에 기록 (정렬 시간 포함)
+        if (len == SEED_LEN) {
+            int batch = searchBatch > 1 ? searchBatch : 16;
+            measure("batched binary search (B=" + to_string(batch) + ", " + to_string(blockSize) + "개씩 시드 정렬)", got,
+                    [&](vector<pair<Pos, Pos>>& o) {
+                        vector<uint64_t> order, tmp;
+                        vector<int> lane;
+                        for (size_t first = 0; first < reads.size(); first += blockSize) {
+                            size_t n = min(blockSize, reads.size() - first);
+                            order.clear();
+                            for (size_t i = 0; i < n; ++i) order.push_back((uint64_t)seedKey(seed(first + i)) << 32 | i);
+                            searchSortedSeeds(idx, order, tmp, lane, batch, [&](int i) { return seed(first + i); },
+                                              [&](int i, const pair<Pos, Pos>& range, uint64_t) { o[first + i] = range; });
+                        }
+                    });
+        }
+        if (idx.kmerK > 0 && len >= idx.kmerK)
+            run("k-mer table (k=" + to_string(idx.kmerK) + ")", got, [&](string_view seed) {
+                return findPrefixRangeKmer(idx.reference, idx.sa, idx.lcp, idx.kmerStart, idx.kmerK, seed);
+            });
+        if (idx.llcp.size() > 0)
+            run("LCP-LR (mlr)", got, [&](string_view seed) {
+                return findPrefixRangeLCP(idx.reference, idx.sa, idx.llcp, idx.rlcp, seed);
+            });
+    }
+
+    // 후보 위치 조회 비용: SA는 배열 접근 한 번, FM은 샘플된 행까지 LF 이동
+    len = SEED_LEN;
+    long long hits = 0, mismatched = 0;
+    volatile long long sink = 0;
+    auto t1 = high_resolution_clock::now();
+    for (size_t i = 0; i < reads.size(); ++i) {
+        auto [l, r] = seedRange(idx, seed(i));
+        for (Pos j = l; j < min(r, l + 100); ++j, ++hits) {
+            Pos pos = seedPos(idx, j);
+            sink += pos;
+            if (idx.backend == IndexBackend::FM && idx.sa.size() > 0 && pos != idx.sa[j]) ++mismatched;
+        }
+    }
+    auto t2 = high_resolution_clock::now();
+    if (hits > 0) {
+        double ns = chrono::duration_cast<chrono::duration<double, nano>>(t2 - t1).count() / hits;
+        cout << "[후보 위치 조회] " << (idx.backend == IndexBackend::FM ? "FM locate" : "SA") << ": " << ns
+             << " ns/hit (시드 검색 포함, " << hits << " hits)";
+        if (idx.backend == IndexBackend::FM && idx.sa.size() > 0)
+            cout << (mismatched == 0 ? " (SA와 일치)" : " (SA와 불일치 " + to_string(mismatched) + "건)");
+        cout << "\n";
+    }
+}
+
+// 출력 형식별 기록 처리량 비교 (단일 스레드)
+// read를 한 번 정렬해 둔 결과를 형식마다 WRITE_BUFFER 크기 버퍼에 만들어 /dev/null에 write()로 기록
+// 비교 기준으로 예전처럼 ofstream << 로 text를 쓰는 경우도 측정
+const size_t WRITE_BUFFER = 1 << 20;
+
+void benchWriters(const SAIndex& idx, const vector<string>& reads, const AlignOptions& opt) {
+    if (reads.empty()) return;
+    vector<AlignResult> results(reads.size());
+    AlignScratch scratch;
+    AlignOptions alignOpt = opt;
+    alignOpt.cache = nullptr;  // 여기서 채운 캐시가 본 정렬 처리량을 바꾸지 않도록
+    for (size_t i = 0; i < reads.size(); ++i) results[i] = alignRead(idx, reads[i], scratch, alignOpt);
+
+    cout << "[출력 기록 벤치마크] reads=" << reads.size() << "\n";
+    auto report = [&](const string& label, double sec, uint64_t bytes) {
+        cout << "  " << label << ": " << (sec > 0 ? reads.size() / sec : 0) << " reads/s, "
+             << (sec > 0 ? bytes / sec / 1048576.0 : 0) << " MB/s (" << double(bytes) / reads.size() << " 바이트/read)\n";
+    };
+
+    uint64_t textBytes = 0;
+    for (OutputFormat format : {OutputFormat::Text, OutputFormat::Binary, OutputFormat::SAM}) {
+        OutputFile fout("/dev/null");
+        string buf;
+        buf.reserve(WRITE_BUFFER + 4096);
+        auto t1 = high_resolution_clock::now();
+        formatHeader(buf, idx.layout, format);
+        for (size_t i = 0; i < reads.size(); ++i) {
+            formatResult(buf, i, reads[i], results[i], idx.layout, format);
+            if (buf.size() >= WRITE_BUFFER) {
+                fout.write(buf);
+                buf.clear();
+            }
+        }
+        fout.write(buf);
+        auto t2 = high_resolution_clock::now();
+        if (format == OutputFormat::Text) textBytes = fout.bytes();
+        report(formatName(format), chrono::duration_cast<chrono::duration<double>>(t2 - t1).count(), fout.bytes());
+    }
+
+    // /dev/null은 tellp가 0이므로 크기는 위 text 결과와 같다고 봄
+    {
+        ofstream fout("/dev/null");
+        auto t1 = high_resolution_clock::now();
+        for (size_t i = 0; i < reads.size(); ++i) {
+            const AlignResult& res = results[i];
+            fout << "read index: " << i;
+            if (res.pos == -1) {
+                fout << " -> no match\n";
+                continue;
+            }
+            const Contig& c = idx.layout.contigs[idx.layout.contigOf(res.pos)];
+            fout << " -> pos: ";
+            if (c.name.empty()) fout << res.pos;
+            else fout << c.name << ':' << res.pos - c.start;
+            fout << ", mismatch: " << res.mismatch << ", strand: " << (res.reverse ? '-' : '+') << ", mapq: " << res.mapq;
+            if (res.second <= res.mismatch) fout << ", multi-mapped";
+            if (!res.cigar.empty()) fout << ", cigar: " << res.cigar;
+            fout << "\n";
+        }
+        fout.flush();
+        auto t2 = high_resolution_clock::now();
+        report("text (ofstream <<, 기준)", chrono::duration_cast<chrono::duration<double>>(t2 - t1).count(), textBytes);
+    }
+}
+
+// 인덱스 배치별 정렬 처리량 비교: 원래 위치(인덱스 파일 mmap 또는 구축한 vector), 4KB 페이지 복사본,
+// huge page 복사본, huge page + NUMA 노드별 복제본 (캐시 없이, 배치마다 3번 중 가장 빠른 값)
+void benchPlacement(const SAIndex& idx, const vector<string>& reads, const AlignOptions& opt, HugePageMode mode,
+                    int threads, size_t blockSize) {
+    AlignOptions base = opt;
+    base.cache = nullptr;
+    base.replicas = nullptr;
+    if (mode == HugePageMode::Off) mode = HugePageMode::Huge2M;
+    cout << "[인덱스 배치 벤치마크] reads=" << reads.size() << ", 스레드 " << threads << "개\n";
+    auto run = [&](const string& label, const SAIndex& index, const AlignOptions& o) {
+        double best = 0;
+        for (int r = 0; r < 3; ++r) {
+            auto t1 = high_resolution_clock::now();
+            alignReads(index, reads, [](string_view) {}, o, threads, blockSize);
+            double sec = chrono::duration_cast<chrono::duration<double>>(high_resolution_clock::now() - t1).count();
+            if (sec > 0) best = max(best, reads.size() / sec);
+        }
+        cout << "  " << label << ": " << best << " reads/s\n";
+    };
+    run(idx.mapAddr ? "원래 위치 (인덱스 파일 mmap)" : "원래 위치 (구축한 vector)", idx, base);
+    for (HugePageMode m : {HugePageMode::Off, mode}) {
+        SAIndex placed;
+        string backing;
+        if (!placeIndex(idx, placed, m, -1, backing)) {
+            cerr << "경고: 인덱스 복사본을 할당하지 못함\n";
+            return;
+        }
+        run("복사본 (" + backing + ", huge page " + to_string(hugePageBytes(placed.mapAddr) >> 20) + " MB)", placed, base);
+    }
+    IndexReplicas replicas;
+    if (!buildReplicas(idx, mode, replicas)) {
+        cerr << "경고: NUMA 복제본을 할당하지 못함\n";
+        return;
+    }
+    AlignOptions local = base;
+    local.replicas = &replicas;
+    run("huge page + NUMA 노드별 복제본 " + to_string(replicas.nodes.size()) + "개", idx, local);
+}
+
+// 스레드 수를 1, 2, 4, ... maxThreads(최대 64)로 바꿔 가며 병렬 SA, LCP 구축 단계별 시간 비교
+// 각 결과가 SA-IS + Kasai 결과와 같은지도 확인
+void buildThreadScan(const string& reference, int maxThreads) {
+    vector<Pos> refSA = buildSuffixArraySAIS(reference);
+    PosStorage refPacked = packPositions(vector<Pos>(refSA));
+    vector<int> refLCP = buildLCPArray(reference, viewPositions(refPacked));
+    // 위성 반복처럼 같은 단위가 길게 이어진 reference (171bp × 3000): 병렬 구축이 반복 길이에 비례해 느려지지 않는지 확인
+    string repeat, unit;
+    uint32_t x = 12345;
+    for (int i = 0; i < 171; ++i) unit += "ACGT"[(x = x * 1103515245 + 12345) >> 16 & 3];
+    for (int i = 0; i < 3000; ++i) repeat += unit;
+    repeat += "GATTACA";
+    vector<Pos> repeatSA = buildSuffixArraySAIS(repeat);
+    double sa1 = 0, lcp1 = 0;
+    cout << "[구축 스레드 확장성] N=" << reference.size() << " bp\n";
+    for (int t = 1; t <= min(maxThreads, 64); t *= 2) {
+        auto t1 = high_resolution_clock::now();
+        vector<Pos> sa = buildSuffixArrayParallel(reference, t);
+        auto t2 = high_resolution_clock::now();
+        PosStorage packed = packPositions(vector<Pos>(sa));
+        auto t3 = high_resolution_clock::now();
+        vector<int> lcp = buildLCPArrayParallel(reference, viewPositions(packed), t);
+        auto t4 = high_resolution_clock::now();
+        double saSec = chrono::duration_cast<chrono::duration<double>>(t2 - t1).count();
+        double lcpSec = chrono::duration_cast<chrono::duration<double>>(t4 - t3).count();
+        if (t == 1) sa1 = saSec, lcp1 = lcpSec;
+        cout << "  " << t << " 스레드: SA " << saSec << "초 (x" << sa1 / saSec << "), LCP " << lcpSec << "초 (x" << lcp1 / lcpSec
+             << ")" << (sa == refSA && lcp == refLCP ? "" : "  ⚠ SA-IS/Kasai 결과와 다름") << "\n";
+        t1 = high_resolution_clock::now();
+        bool repeatOk = buildSuffixArrayParallel(repeat, t) == repeatSA;
+        t2 = high_resolution_clock::now();
+        cout << "    반복 reference (" << unit.size() << "bp × 3000): SA "
+             << chrono::duration_cast<chrono::duration<double>>(t2 - t1).count() << "초"
+             << (repeatOk ? "" : "  ⚠ SA-IS 결과와 다름") << "\n";
+    }
+}
+
+void printUsage(const char* prog) {
+    cerr << "사용법: " << prog << " [build-index | align | serve] [옵션]\n"
+         << "  (모드 없음)    reference로 인덱스를 메모리에 구축한 뒤 바로 정렬\n"
+         << "  build-index   reference로 인덱스를 구축하여 --index 파일에 저장\n"
+         << "  align         --index 파일을 mmap으로 불러와 정렬\n"
+         << "  serve         인덱스를 한 번 구축(--index를 주면 mmap으로 로드)하고 --socket으로 정렬 요청을 계속 받음\n"
+         << "옵션:\n"
+         << "  --sa=sais|doubling|parallel  SA 구축 방식 (기본값: sais, parallel은 --threads개 스레드로 k-mer 버킷별 병렬 정렬)\n"
+         << "  --build-scan         스레드 수 1, 2, 4, ... --threads(최대 64)별 병렬 SA/LCP 구축 시간 비교\n"
+         << "  --backend=sa|fm      시드 검색 엔진: SA 이진 탐색 또는 FM-index backward search (기본값: sa)\n"
+         << "  --ref=FILE           reference 파일 (기본값: reference.txt)\n"
+         << "  --reads=FILE         read 파일 (기본값: reads.txt)\n"
+         << "  --reads2=FILE        paired-end: --reads와 같은 순서의 mate 2 파일\n"
+         << "  --interleaved        paired-end: --reads 파일에 mate 1, mate 2가 번갈아 있음\n"
+         << "  --max-insert=N       paired-end: insert size 상한이자 추정 전 mate rescue 구간 (기본값: 1000)\n"
+         << "  --out=FILE           결과 파일 (기본값: result.txt)\n"
+         << "  --format=text|binary|sam  결과 형식: 텍스트, 고정 크기 binary 레코드, 최소 SAM (기본값: text)\n"
+         << "  --writer-bench       정렬 전에 출력 형식별 기록 처리량 비교 출력\n"
+         << "  --huge-pages=off|2m|1g  정렬 전에 인덱스를 huge page 익명 메모리로 복사 (hugetlb가 없으면 THP, 기본값: off)\n"
+         << "  --numa-replicas      NUMA 노드마다 인덱스 복제본을 두고 정렬 스레드를 자기 노드에 고정\n"
+         << "  --placement-bench    정렬 전에 인덱스 배치(원래 위치, 복사본, huge page, NUMA 복제본)별 처리량 비교 출력\n"
+         << "  --index=FILE         인덱스 파일 (기본값: reference.idx)\n"
+         << "  --socket=PATH        serve 모드의 Unix 도메인 소켓 경로 (기본값: aligner.sock)\n"
+         << "  --verify             인덱스 로드 시 체크섬 검사\n"
+         << "  --kmer=K             k-mer 직접 조회 테이블 구축 (K=1~15, 0이면 사용 안 함, 기본값: 0)\n"
+         << "  --simd=auto|avx512|avx2|scalar  mismatch 커널 선택 (기본값: auto, CPU 지원 여부를 실행 시점에 확인)\n"
+         << "  --lcp-search         LCP-LR 배열을 구축하여 Manber-Myers 방식으로 시드 검색\n"
+         << "  --forward-only       정방향 가닥만 검색 (기본값: 역상보까지 양쪽 가닥 검색)\n"
+         << "  --edit-distance      Hamming으로 맞지 않는 read를 밴드 편집 거리(Myers)로 재검증하여 indel 허용, CIGAR 출력\n"
+         << "  --multi-seed         read를 겹치지 않는 여러 시드로 나눠 검색 (앞부분에 mismatch가 있어도 매칭)\n"
+         << "  --max-seed-hits=N    multi-seed/spaced seed에서 시드 하나당 검증할 최대 후보 수 (기본값: 500)\n"
+         << "  --read-cache=MB      같은 서열 read의 결과를 MB 예산 안에서 캐시하여 다시 정렬하지 않음 (기본값: 0, 사용 안 함)\n"
+         << "  --max-candidates=N   단일 접두사 경로에서 첫 시드 구간당 검증할 최대 후보 수 (기본값: 256, 넘으면 우선순위대로 골라 검증)\n"
+         << "  --spaced-seeds=LIST  spaced seed 인덱스로도 후보 검색 (예: 1101101,1110101 또는 all)\n"
+         << "  --seed-bench         정렬 전에 시드 검색 방식별 속도 비교 출력\n"
+         << "  --search-batch=N     첫 시드를 N개 read씩 묶어 번갈아 이진 탐색 (1~64, 1이면 사용 안 함, 기본값: 16)\n"
+         << "  --sort-seeds         묶음 이진 탐색 전에 --batch-size 묶음의 read를 첫 시드 2비트 코드로 radix 정렬 (출력 순서는 그대로)\n"
+         << "  --stream             read를 묶음 단위로 읽으며 정렬 (read 수와 무관하게 메모리 고정, FASTQ 지원)\n"
+         << "  --threads=N          정렬 스레드 수 (기본값: 하드웨어 스레드 수)\n"
+         << "  --batch-size=N       스레드가 한 번에 맡는 read 수 (기본값: 4096)\n"
+         << "  --thread-scan        스레드 수 1, 2, 4, ... --threads(최대 64)별 정렬 처리량 비교\n"
+         << "  --profile=FILE       정렬 단계 카운터와 지연 시간 히스토그램을 JSON으로 기록 (-DALIGNER_PROFILE로 컴파일한 경우)\n"
+         << "  --profile-interval=SEC  정렬 중에도 SEC초마다 --profile 파일을 갱신\n";
+}
+
+// 메인 함수: 전체 파이프라인 실행
+int main(int argc, char* argv[]) {
+    enum class Mode { All, BuildIndex, Align, Serve } mode = Mode::All;
+    SABuilder saBuilder = SABuilder::SAIS;
+    string refFile = "reference.txt", readsFile = "reads.txt", outFile = "result.txt", indexFile = "reference.idx";
+    string socketPath = "aligner.sock", reads2File;
+    bool indexGiven = false, interleaved = false;
+    long long maxInsert = 1000;
+    bool verify = false, seedBench = false, lcpSearch = false, stream = false, scan = false, buildScan = false;
+    bool writerBench = false, placementBench = false, numaReplicas = false;
+    HugePageMode hugePages = HugePageMode::Off;
+    IndexBackend backend = IndexBackend::SA;
+    int kmerK = 0;
+    int threads = max(1u, thread::hardware_concurrency());
+    size_t batchSize = 4096;
+    string simd = "auto";
+    string profileFile;
+    double profileInterval = 0;
+    size_t readCacheMB = 0;
+    AlignOptions alignOpt;
+
+    for (int a = 1; a < argc; ++a) {
+        string arg = argv[a];
+        auto value = [&](const string& key) { return arg.substr(key.size()); };
+        if (a == 1 && arg == "build-index") mode = Mode::BuildIndex;
+        else if (a == 1 && arg == "align") mode = Mode::Align;
+        else if (a == 1 && arg == "serve") mode = Mode::Serve;
+        else if (arg == "--sa=doubling") saBuilder = SABuilder::Doubling;
+        else if (arg == "--sa=sais") saBuilder = SABuilder::SAIS;
+        else if (arg == "--sa=parallel") saBuilder = SABuilder::Parallel;
+        else if (arg == "--build-scan") buildScan = true;
+        else if (arg == "--backend=sa") backend = IndexBackend::SA;
+        else if (arg == "--backend=fm") backend = IndexBackend::FM;
+        else if (arg.rfind("--ref=", 0) == 0) refFile = value("--ref=");
+        else if (arg.rfind("--reads=", 0) == 0) readsFile = value("--reads=");
+        else if (arg.rfind("--reads2=", 0) == 0) reads2File = value("--reads2=");
+        else if (arg == "--interleaved") interleaved = true;
+        else if (arg.rfind("--max-insert=", 0) == 0) maxInsert = max(1LL, atoll(value("--max-insert=").c_str()));
+        else if (arg.rfind("--out=", 0) == 0) outFile = value("--out=");
+        else if (arg.rfind("--index=", 0) == 0) {
+            indexFile = value("--index=");
+            indexGiven = true;
+        }
+        else if (arg.rfind("--socket=", 0) == 0) socketPath = value("--socket=");
+        else if (arg == "--verify") verify = true;
+        else if (arg == "--seed-bench") seedBench = true;
+        else if (arg == "--writer-bench") writerBench = true;
+        else if (arg == "--placement-bench") placementBench = true;
+        else if (arg == "--huge-pages=off") hugePages = HugePageMode::Off;
+        else if (arg == "--huge-pages=2m") hugePages = HugePageMode::Huge2M;
+        else if (arg == "--huge-pages=1g") hugePages = HugePageMode::Huge1G;
+        else if (arg == "--numa-replicas") numaReplicas = true;
+        else if (arg == "--format=text") alignOpt.format = OutputFormat::Text;
+        else if (arg == "--format=binary") alignOpt.format = OutputFormat::Binary;
+        else if (arg == "--format=sam") alignOpt.format = OutputFormat::SAM;
+        else if (arg == "--lcp-search") lcpSearch = true;
+        else if (arg == "--multi-seed") alignOpt.multiSeed = true;
+        else if (arg == "--sort-seeds") alignOpt.sortSeeds = true;
+        else if (arg == "--forward-only") alignOpt.bothStrands = false;
+        else if (arg == "--edit-distance") alignOpt.editDistance = true;
+        else if (arg == "--stream") stream = true;
+        else if (arg == "--thread-scan") scan = true;
+        else if (arg.rfind("--profile=", 0) == 0) profileFile = value("--profile=");
+        else if (arg.rfind("--profile-interval=", 0) == 0) profileInterval = atof(value("--profile-interval=").c_str());
+        else if (arg.rfind("--search-batch=", 0) == 0) {
+            alignOpt.searchBatch = atoi(value("--search-batch=").c_str());
+            if (alignOpt.searchBatch < 1 || alignOpt.searchBatch > MAX_SEARCH_BATCH) {
+                cerr << "--search-batch는 1~" << MAX_SEARCH_BATCH << " 사이여야 함\n";
+                return 1;
+            }
+        }
+        else if (arg.rfind("--threads=", 0) == 0) threads = max(1, atoi(value("--threads=").c_str()));
+        else if (arg.rfind("--batch-size=", 0) == 0) batchSize = max(1, atoi(value("--batch-size=").c_str()));
+        else if (arg.rfind("--spaced-seeds=", 0) == 0) {
+            alignOpt.spacedSeeds = parseSpacedSeeds(value("--spaced-seeds="));
+            if (alignOpt.spacedSeeds < 0) {
+                cerr << "알 수 없는 spaced seed 패턴: " << value("--spaced-seeds=") << " (사용 가능:";
+                for (const char* pat : SPACED_SEED_PATTERNS) cerr << " " << pat;
+                cerr << ", all)\n";
+                return 1;
+            }
+        }
+        else if (arg.rfind("--read-cache=", 0) == 0) readCacheMB = max(0, atoi(value("--read-cache=").c_str()));
+        else if (arg.rfind("--max-candidates=", 0) == 0)
+            alignOpt.maxCandidates = max(1, atoi(value("--max-candidates=").c_str()));
+        else if (arg.rfind("--max-seed-hits=", 0) == 0) alignOpt.maxSeedHits = max(1, atoi(value("--max-seed-hits=").c_str()));
+        else if (arg == "--simd=auto" || arg == "--simd=avx512" || arg == "--simd=avx2" || arg == "--simd=scalar")
+            simd = value("--simd=");
+        else if (arg.rfind("--kmer=", 0) == 0) {
+            kmerK = atoi(value("--kmer=").c_str());
+            if (kmerK < 0 || kmerK > 15) {
+                cerr << "--kmer는 0~15 사이여야 함\n";
+                return 1;
+            }
+        }
+        else {
+            cerr << "알 수 없는 옵션: " << arg << "\n";
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (!profileFile.empty() && !PROFILE_ENABLED) {
+        cerr << "경고: 계측 코드 없이 컴파일되어 --profile을 무시함 (-DALIGNER_PROFILE로 다시 컴파일)\n";
+        profileFile.clear();
+    }
+
+    // align은 항상, serve는 --index를 준 경우 인덱스 파일을 불러옴 / read 파일은 (모드 없음)과 align에서만 미리 읽음
+    bool fromIndex = mode == Mode::Align || (mode == Mode::Serve && indexGiven);
+    bool loadsReads = (mode == Mode::All || mode == Mode::Align) && !stream;
+    bool paired = !reads2File.empty() || interleaved;
+    if (paired && (stream || mode == Mode::Serve || mode == Mode::BuildIndex)) {
+        cerr << "paired-end 모드(--reads2, --interleaved)는 (모드 없음)과 align에서 --stream 없이만 쓸 수 있음\n";
+        return 1;
+    }
+
+    if (backend == IndexBackend::FM && !fromIndex && (kmerK > 0 || lcpSearch)) {
+        cerr << "경고: FM 백엔드에서는 --kmer, --lcp-search를 사용하지 않음\n";
+        kmerK = 0;
+        lcpSearch = false;
+    }
+
+    auto total_start = high_resolution_clock::now();
+    SAIndex idx;
+    vector<string> reads, reads2;  // paired-end면 reads[i], reads2[i]가 쌍 i의 mate 1, 2
+
+    auto t1 = high_resolution_clock::now();
+    string reference;
+    if (!fromIndex) reference = loadReference(refFile, idx.layout);
+    if (loadsReads) reads = loadReads(readsFile);
+    if (paired && interleaved) {
+        if (reads.size() % 2) {
+            cerr << "interleaved read 파일의 read 수가 홀수: " << reads.size() << "\n";
+            return 1;
+        }
+        for (size_t i = 0; i < reads.size() / 2; ++i) {
+            reads2.push_back(move(reads[2 * i + 1]));
+            if (i > 0) reads[i] = move(reads[2 * i]);
+        }
+        reads.resize(reads2.size());
+    } else if (paired) {
+        reads2 = loadReads(reads2File);
+        if (reads2.size() != reads.size()) {
+            cerr << "두 read 파일의 read 수가 다름: " << reads.size() << ", " << reads2.size() << "\n";
+            return 1;
+        }
+    }
+    auto t2 = high_resolution_clock::now();
+
+    if (!fromIndex && reference.size() > MAX_REF_LEN) {
+        cerr << "reference가 너무 김: " << reference.size() << " bp (이 빌드는 최대 " << MAX_REF_LEN << " bp";
+        if (POS_BYTES == 4) cerr << ", 더 긴 reference는 -DALIGNER_POS40으로 다시 컴파일해야 함";
+        cerr << ")\n";
+        return 1;
+    }
+    if (!fromIndex) cout << "Reference length (N): " << reference.size() << " bp\n";
+    if (loadsReads && paired) cout << "Number of pairs: " << reads.size() << " pairs\n";
+    else if (loadsReads) cout << "Number of reads (M): " << reads.size() << " reads\n";
+    printTime("[1] 입력 로딩:", t1, t2);
+
+    t1 = high_resolution_clock::now();
+    if (fromIndex) {
+        if (!loadIndex(idx, indexFile, verify)) return 1;
+        t2 = high_resolution_clock::now();
+        cout << "Reference length (N): " << idx.reference.size() << " bp\n";
+        printTime("[2] 인덱스 로드 (mmap):", t1, t2);
+    } else {
+        if (buildScan) buildThreadScan(reference, threads);
+        t1 = high_resolution_clock::now();
+        buildIndex(idx, move(reference), saBuilder, threads, kmerK, lcpSearch, backend, seedBench && mode == Mode::All);
+        t2 = high_resolution_clock::now();
+        string what = backend == IndexBackend::FM ? "SA + FM-index" : "SA + LCP";
+        const char* how = saBuilder == SABuilder::SAIS ? " 생성 (SA-IS):" : saBuilder == SABuilder::Doubling ? " 생성 (doubling):"
+                                                                                                         : " 생성 (병렬 버킷 정렬):";
+        printTime("[2] " + what + how, t1, t2);
+    }
+    bool missingSpaced = false;
+    for (int p = 0; p < SPACED_SEED_COUNT; ++p)
+        missingSpaced |= (alignOpt.spacedSeeds >> p & 1) && idx.spaced[p].size() == 0;
+    if (missingSpaced) {
+        if (fromIndex) cerr << "경고: 인덱스 파일에 없는 spaced seed 인덱스를 메모리에서 구축함\n";
+        t1 = high_resolution_clock::now();
+        buildSpacedSeedIndexes(idx, alignOpt.spacedSeeds);
+        t2 = high_resolution_clock::now();
+        printTime("[2-1] spaced seed 인덱스 생성:", t1, t2);
+    }
+    cout << "contig: " << idx.layout.contigs.size() << "개, N 염기: " << idx.layout.nBases() << " (구간 "
+         << idx.layout.nRuns.size() << "개)\n";
+    cout << "reference (2비트 압축): " << packedWords(idx.reference.size()) * sizeof(uint64_t) / 1048576.0 << " MB\n";
+    if (idx.backend == IndexBackend::SA)
+        cout << "SA (위치 " << POS_BYTES << "바이트) + LCP: " << (posArrayBytes(idx.sa.size()) + idx.lcp.size() * sizeof(int)) / 1048576.0
+             << " MB\n";
+    else
+        cout << "FM-index (occ 블록 + SA 샘플 1/" << FM_SA_SAMPLE << "): " << fmIndexBytes(idx.fm) / 1048576.0 << " MB\n";
+    if (idx.kmerK > 0)
+        cout << "k-mer 테이블 (k=" << idx.kmerK << "): " << posArrayBytes(idx.kmerStart.size()) / 1048576.0 << " MB\n";
+    if (idx.llcp.size() > 0)
+        cout << "LCP-LR 배열: " << 2 * idx.llcp.size() * sizeof(int) / 1048576.0 << " MB\n";
+    for (int p = 0; p < SPACED_SEED_COUNT; ++p)
+        if (idx.spaced[p].size() > 0)
+            cout << "spaced seed 인덱스 (" << SPACED_SEED_PATTERNS[p] << "): " << posArrayBytes(idx.spaced[p].size()) / 1048576.0 << " MB\n";
+    if (seedBench && (mode == Mode::All || mode == Mode::Align)) {
+        if (stream) cerr << "경고: --seed-bench는 --stream과 함께 쓸 수 없어 생략함\n";
+        else benchSeedSearch(idx, reads, alignOpt.searchBatch, batchSize);
+    }
+
+    if (mode == Mode::BuildIndex) {
+        t1 = high_resolution_clock::now();
+        if (!saveIndex(idx, indexFile)) return 1;
+        t2 = high_resolution_clock::now();
+        printTime("[3] 인덱스 저장 (" + indexFile + "):", t1, t2);
+    } else {
+        string kernelName;
+        alignOpt.countMismatch = selectMismatchKernel(simd, kernelName);
+        cout << "mismatch 커널: " << kernelName << "\n";
+        unique_ptr<ReadCache> readCache;
+        if (readCacheMB > 0) {
+            readCache = make_unique<ReadCache>(readCacheMB << 20);
+            alignOpt.cache = readCache.get();
+            cout << "read 캐시: " << readCacheMB << " MB (최대 " << readCache->maxEntries() << "개)\n";
+        }
+        if (writerBench && mode != Mode::Serve) {
+            if (stream) cerr << "경고: --writer-bench는 --stream과 함께 쓸 수 없어 생략함\n";
+            else benchWriters(idx, reads, alignOpt);
+        }
+        if (placementBench && mode != Mode::Serve) {
+            if (stream) cerr << "경고: --placement-bench는 --stream과 함께 쓸 수 없어 생략함\n";
+            else benchPlacement(idx, reads, alignOpt, hugePages, threads, batchSize);
+        }
+        IndexReplicas replicas;
+        if (numaReplicas) {
+            t1 = high_resolution_clock::now();
+            if (!buildReplicas(idx, hugePages, replicas)) {
+                cerr << "NUMA 복제본 메모리 할당 실패\n";
+                return 1;
+            }
+            alignOpt.replicas = &replicas;
+            t2 = high_resolution_clock::now();
+            printTime("[2-2] NUMA 노드별 인덱스 복제본 " + to_string(replicas.nodes.size()) + "개:", t1, t2);
+        } else if (hugePages != HugePageMode::Off) {
+            t1 = high_resolution_clock::now();
+            string backing;
+            if (!placeIndex(idx, idx, hugePages, -1, backing)) {
+                cerr << "인덱스 메모리 할당 실패\n";
+                return 1;
+            }
+            t2 = high_resolution_clock::now();
+            cout << "인덱스 배치: " << idx.mapSize / 1048576.0 << " MB (" << backing << ", huge page "
+                 << (hugePageBytes(idx.mapAddr) >> 20) << " MB)\n";
+            printTime("[2-2] 인덱스 huge page 복사:", t1, t2);
+        }
+        unique_ptr<ProfileDumper> profileDumper;
+        if (!profileFile.empty()) profileDumper = make_unique<ProfileDumper>(profileFile, profileInterval);
+        if (mode == Mode::Serve) {
+            t1 = high_resolution_clock::now();
+            AlignStats stats;
+            if (!serveRequests(idx, alignOpt, socketPath, threads, stats)) return 1;
+            t2 = high_resolution_clock::now();
+            printAlignStats(stats, alignOpt);
+            printTime("[3] 서버 실행 시간:", t1, t2);
+        } else {
+            OutputFile fout(outFile);
+            if (!fout.isOpen()) {
+                cerr << "결과 파일을 열 수 없음: " << outFile << "\n";
+                return 1;
+            }
+            string header;
+            formatHeader(header, idx.layout, alignOpt.format);
+            bool writeFailed = !fout.write(header);
+            double writeSec = 0;
+            auto write = [&](string_view buf) {
+                auto w1 = high_resolution_clock::now();
+                writeFailed |= !fout.write(buf);
+                writeSec += chrono::duration_cast<chrono::duration<double>>(high_resolution_clock::now() - w1).count();
+            };
+            t1 = high_resolution_clock::now();
+            AlignStats stats;
+            InsertSizeEstimator insert(maxInsert);
+            if (paired) {
+                cout << "paired-end 정렬: 스레드 " << threads << "개\n";
+                if (scan) cerr << "경고: --thread-scan은 paired-end 모드에서 지원하지 않아 생략함\n";
+                stats = alignPairs(idx, reads, reads2, write, alignOpt, threads, batchSize, insert);
+            } else if (stream) {
+                cout << "스트리밍 정렬: 스레드 " << threads << "개, 묶음당 read " << batchSize << "개\n";
+                stats = alignStream(idx, readsFile, write, alignOpt, threads, batchSize);
+                cout << "Number of reads (M): " << stats.reads << " reads\n";
+            } else {
+                cout << "정렬 스레드: " << threads << "개\n";
+                stats = scan ? threadScan(idx, reads, write, alignOpt, threads, batchSize)
+                             : alignReads(idx, reads, write, alignOpt, threads, batchSize);
+            }
+            t2 = high_resolution_clock::now();
+            printAlignStats(stats, alignOpt);
+            printTime("[3] 정렬 수행 완료:", t1, t2);
+            double sec = chrono::duration_cast<chrono::duration<double>>(t2 - t1).count();
+            cout << "정렬 처리량: " << (sec > 0 ? stats.reads / sec : 0) << " reads/s";
+            if (paired) cout << " (" << (sec > 0 ? stats.pairs / sec : 0) << " pairs/s)";
+            cout << "\n";
+            if (paired)
+                cout << "insert size 추정: 표본 " << insert.count() << "쌍, 중앙값 " << insert.median() << ", 허용 구간 ["
+                     << insert.low() << ", " << insert.high() << "]\n";
+            cout << "결과 기록 (" << formatName(alignOpt.format) << "): " << fout.bytes() / 1048576.0 << " MB, write() "
+                 << writeSec << "초\n";
+            if (!fout.close() || writeFailed) {
+                cerr << "결과 파일 기록 실패: " << outFile << "\n";
+                return 1;
+            }
+        }
+        if (profileDumper) {
+            profileDumper.reset();
+            cout << "계측 결과: " << profileFile << "\n";
+        }
+    }
+
+    auto total_end = high_resolution_clock::now();
+    cout << "최대 메모리 사용량 (RSS): " << peakRSSMB() << " MB\n";
 
-    auto total_end = high_resolution_clock::now();
-    
     printTime("✅ 전체 수행 시간:", total_start, total_end);
     return 0;
 }
@@ -10,7 +10,19 @@
 using namespace std;
 using namespace chrono;
 
-int main() {
+// 옵션: --sa=sais (기본값, 선형 시간) | --sa=doubling (기존 방식, 속도 비교용)
+int main(int argc, char* argv[]) {
+    SABuilder saBuilder = SABuilder::SAIS;
+    for (int a = 1; a < argc; ++a) {
+        string arg = argv[a];
+        if (arg == "--sa=doubling") saBuilder = SABuilder::Doubling;
+        else if (arg == "--sa=sais") saBuilder = SABuilder::SAIS;
+        else {
+            cerr << "알 수 없는 옵션: " << arg << endl;
+            return 1;
+        }
+    }
+
     // 전체 수행 시간 측정 시작
     auto total_start = high_resolution_clock::now();
 
@@ -23,7 +35,7 @@ int main() {
 
     // [2] 접미사 배열(Suffix Array) 및 LCP 생성
     t1 = high_resolution_clock::now();
-    vector<int> sa = buildSuffixArray(reference);          // 접미사 배열 생성
+    vector<int> sa = buildSuffixArray(reference, saBuilder); // 접미사 배열 생성 (선택한 방식)
     vector<int> lcp = buildLCPArray(reference + '\0', sa); // LCP 배열 생성 (문자열 종료문자 필요)
     t2 = high_resolution_clock::now();
     printTime("[2] SA + LCP 생성:", t1, t2);               // 경과 시간 출력
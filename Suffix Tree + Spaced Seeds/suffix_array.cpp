@@ -5,9 +5,9 @@
 
 using namespace std;
 
-// 접미사 배열(Suffix Array) 구축 함수
+// 접미사 배열(Suffix Array) 구축 함수 (Doubling 방식)
 // 입력 문자열의 모든 접미사를 정렬한 후, 해당 접미사의 시작 인덱스를 배열로 반환
-vector<int> buildSuffixArray(const string& s_input) {
+vector<int> buildSuffixArrayDoubling(const string& s_input) {
     string s = s_input + '\0';  // 널 문자를 끝에 추가 (정렬 안정성 확보 목적)
     int n = s.size();
 
@@ -51,6 +51,125 @@ vector<int> buildSuffixArray(const string& s_input) {
     return sa;
 }
 
+// SA-IS 보조 함수: 문자별 버킷의 시작(end=false) 또는 끝(end=true) 위치 계산
+void getBuckets(const int* s, int n, int K, int* bkt, bool end) {
+    fill(bkt, bkt + K, 0);
+    for (int i = 0; i < n; ++i) bkt[s[i]]++;  // 문자별 등장 횟수
+    int sum = 0;
+    for (int c = 0; c < K; ++c) {
+        sum += bkt[c];
+        bkt[c] = end ? sum : sum - bkt[c];
+    }
+}
+
+// SA-IS 보조 함수: 자리를 잡은 LMS 접미사로부터 L형 → S형 순서로 나머지 접미사를 유도 정렬
+void induceSA(const int* s, const vector<bool>& t, int* sa, int n, int K, int* bkt) {
+    getBuckets(s, n, K, bkt, false);  // L형은 버킷 앞에서부터 채움
+    for (int i = 0; i < n; ++i) {
+        int j = sa[i] - 1;
+        if (sa[i] > 0 && !t[j]) sa[bkt[s[j]]++] = j;
+    }
+    getBuckets(s, n, K, bkt, true);   // S형은 버킷 뒤에서부터 채움
+    for (int i = n - 1; i >= 0; --i) {
+        int j = sa[i] - 1;
+        if (sa[i] > 0 && t[j]) sa[--bkt[s[j]]] = j;
+    }
+}
+
+// SA-IS 본체 (Nong-Zhang-Chan 알고리즘)
+// s[n-1]은 유일한 최소 문자(0)여야 한다.
+// 축약 문자열과 그 접미사 배열을 sa 배열 안에 그대로 두므로
+// 추가 메모리는 타입 비트 n개와 버킷 K개뿐이다.
+void sais(const int* s, int* sa, int n, int K) {
+    vector<bool> t(n);   // true: S형, false: L형
+    vector<int> bkt(K);
+    t[n - 1] = true;
+    for (int i = n - 2; i >= 0; --i)
+        t[i] = s[i] < s[i + 1] || (s[i] == s[i + 1] && t[i + 1]);
+    auto isLMS = [&](int i) { return i > 0 && t[i] && !t[i - 1]; };
+
+    // [1] LMS 부분 문자열 정렬
+    getBuckets(s, n, K, bkt.data(), true);
+    fill(sa, sa + n, -1);
+    for (int i = 1; i < n; ++i)
+        if (isLMS(i)) sa[--bkt[s[i]]] = i;
+    induceSA(s, t, sa, n, K, bkt.data());
+
+    int n1 = 0;  // LMS 위치 개수
+    for (int i = 0; i < n; ++i)
+        if (isLMS(sa[i])) sa[n1++] = sa[i];
+
+    // LMS 부분 문자열마다 이름 부여 (같은 부분 문자열은 같은 이름)
+    fill(sa + n1, sa + n, -1);
+    int name = 0, prev = -1;
+    for (int i = 0; i < n1; ++i) {
+        int pos = sa[i];
+        bool diff = false;
+        for (int d = 0; d < n; ++d) {
+            if (prev == -1 || s[pos + d] != s[prev + d] || t[pos + d] != t[prev + d]) {
+                diff = true;
+                break;
+            }
+            if (d > 0 && (isLMS(pos + d) || isLMS(prev + d))) break;
+        }
+        if (diff) {
+            ++name;
+            prev = pos;
+        }
+        sa[n1 + pos / 2] = name - 1;
+    }
+    for (int i = n - 1, j = n - 1; i >= n1; --i)
+        if (sa[i] >= 0) sa[j--] = sa[i];
+
+    // [2] 축약 문자열 s1의 접미사 배열 계산 (이름이 모두 다르면 재귀 없이 바로 계산)
+    int* sa1 = sa;
+    int* s1 = sa + n - n1;
+    if (name < n1)
+        sais(s1, sa1, n1, name);
+    else
+        for (int i = 0; i < n1; ++i) sa1[s1[i]] = i;
+
+    // [3] 정렬된 LMS 접미사를 버킷 끝에 놓고 전체 접미사 배열 유도
+    getBuckets(s, n, K, bkt.data(), true);
+    for (int i = 1, j = 0; i < n; ++i)
+        if (isLMS(i)) s1[j++] = i;
+    for (int i = 0; i < n1; ++i) sa1[i] = s1[sa1[i]];
+    fill(sa + n1, sa + n, -1);
+    for (int i = n1 - 1; i >= 0; --i) {
+        int j = sa[i];
+        sa[i] = -1;
+        sa[--bkt[s[j]]] = j;
+    }
+    induceSA(s, t, sa, n, K, bkt.data());
+}
+
+// 접미사 배열(Suffix Array) 구축 함수 (SA-IS 방식, 선형 시간)
+// Doubling 방식과 같은 문자 → 숫자 치환(널=0, A/C/G/T=1~4)을 사용하므로 결과가 동일하다.
+vector<int> buildSuffixArraySAIS(const string& s_input) {
+    int n = s_input.size() + 1;  // 끝의 널 문자 포함
+    vector<int> s_int(n, 0), sa(n);
+    for (int i = 0; i < n - 1; ++i) {
+        char c = s_input[i];
+        if (c == 'A') s_int[i] = 1;
+        else if (c == 'C') s_int[i] = 2;
+        else if (c == 'G') s_int[i] = 3;
+        else if (c == 'T') s_int[i] = 4;
+        else return buildSuffixArrayDoubling(s_input);  // 널 문자가 유일한 최소값이어야 하므로 ACGT 외 문자는 Doubling으로 처리
+    }
+
+    sais(s_int.data(), sa.data(), n, 5);
+    sa.erase(sa.begin());  // 마지막에 추가한 널 문자 인덱스 제거
+    return sa;
+}
+
+// 접미사 배열 구축 방식 선택 (Doubling: 기존 방식, SAIS: 선형 시간)
+enum class SABuilder { Doubling, SAIS };
+
+vector<int> buildSuffixArray(const string& s, SABuilder builder) {
+    if (builder == SABuilder::Doubling) return buildSuffixArrayDoubling(s);
+    return buildSuffixArraySAIS(s);
+}
+
 // LCP(Longest Common Prefix) 배열 생성 함수
 // sa[i]와 sa[i+1]의 공통 접두사 길이를 계산하여 저장
 vector<int> buildLCPArray(const string& s, const vector<int>& sa) {
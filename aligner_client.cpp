@@ -0,0 +1,189 @@
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <cerrno>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+using namespace std;
+using namespace chrono;
+
+// SA.cpp serve 모드의 프로토콜과 같아야 함
+const uint32_t SERVE_MAGIC = 0x51415253;  // "SRAQ"
+enum ServeRequestType : uint32_t { SERVE_ALIGN = 1, SERVE_HEADER = 2, SERVE_STATS = 3, SERVE_SHUTDOWN = 4 };
+
+struct ServeRequest {
+    uint32_t magic;
+    uint32_t type;
+    uint64_t firstIndex;
+    uint64_t readCount;
+    uint64_t payloadBytes;
+};
+
+struct ServeResponse {
+    uint32_t magic;
+    uint32_t status;  // 0: 성공, 1: 오류
+    uint64_t readCount;
+    uint64_t payloadBytes;
+};
+
+// read 목록 로드 (1줄 1 read 또는 FASTQ)
+vector<string> loadReads(const string& file) {
+    ifstream fin(file);
+    vector<string> reads;
+    string line;
+    bool fastq = false, first = true;
+    while (getline(fin, line)) {
+        if (line.empty()) continue;
+        if (first) fastq = line[0] == '@', first = false;
+        if (!fastq) {
+            reads.push_back(line);
+            continue;
+        }
+        if (line[0] != '@' || !getline(fin, line)) continue;
+        reads.push_back(line);
+        getline(fin, line); // '+'
+        getline(fin, line); // 품질
+    }
+    return reads;
+}
+
+bool readFull(int fd, void* buf, size_t n) {
+    char* p = static_cast<char*>(buf);
+    while (n > 0) {
+        ssize_t r = ::read(fd, p, n);
+        if (r < 0 && errno == EINTR) continue;
+        if (r <= 0) return false;
+        p += r;
+        n -= r;
+    }
+    return true;
+}
+
+bool writeFull(int fd, const string& buf) {
+    const char* p = buf.data();
+    size_t n = buf.size();
+    while (n > 0) {
+        ssize_t w = ::write(fd, p, n);
+        if (w < 0 && errno == EINTR) continue;
+        if (w <= 0) return false;
+        p += w;
+        n -= w;
+    }
+    return true;
+}
+
+// 요청 하나를 보내고 응답 payload를 받음 (전송 실패나 서버 오류면 false, 오류 메시지는 payload에)
+bool request(int fd, uint32_t type, uint64_t firstIndex, uint64_t readCount, const string& payload, string& reply) {
+    ServeRequest req{SERVE_MAGIC, type, firstIndex, readCount, payload.size()};
+    string frame(reinterpret_cast<const char*>(&req), sizeof(req));
+    frame += payload;
+    ServeResponse resp;
+    if (!writeFull(fd, frame) || !readFull(fd, &resp, sizeof(resp)) || resp.magic != SERVE_MAGIC) {
+        reply = "서버 연결이 끊김";
+        return false;
+    }
+    reply.resize(resp.payloadBytes);
+    if (!readFull(fd, reply.data(), reply.size())) {
+        reply = "서버 연결이 끊김";
+        return false;
+    }
+    return resp.status == 0;
+}
+
+int main(int argc, char* argv[]) {
+    string socketPath = "aligner.sock", readsFile = "reads.txt", outFile = "result.txt";
+    size_t batch = 1000;
+    bool align = true, stats = false, shutdownServer = false, readsGiven = false;
+    for (int a = 1; a < argc; ++a) {
+        string arg = argv[a];
+        if (arg.rfind("--socket=", 0) == 0) socketPath = arg.substr(9);
+        else if (arg.rfind("--reads=", 0) == 0) readsFile = arg.substr(8), readsGiven = true;
+        else if (arg.rfind("--out=", 0) == 0) outFile = arg.substr(6);
+        else if (arg.rfind("--batch=", 0) == 0) batch = max(1, atoi(arg.substr(8).c_str()));
+        else if (arg == "--stats") stats = true;
+        else if (arg == "--shutdown") shutdownServer = true;
+        else {
+            cerr << "알 수 없는 옵션: " << arg << "\n"
+                 << "사용법: " << argv[0] << " [--socket=PATH] [--reads=FILE] [--out=FILE] [--batch=N] [--stats] [--shutdown]\n"
+                 << "  --reads가 없고 --stats나 --shutdown만 주면 정렬 요청 없이 해당 요청만 보냄\n";
+            return 1;
+        }
+    }
+    if ((stats || shutdownServer) && !readsGiven) align = false;
+
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    if (socketPath.size() >= sizeof(addr.sun_path)) {
+        cerr << "소켓 경로가 너무 김: " << socketPath << "\n";
+        return 1;
+    }
+    memcpy(addr.sun_path, socketPath.c_str(), socketPath.size() + 1);
+    int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0 || ::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+        cerr << "서버에 연결할 수 없음: " << socketPath << " (" << strerror(errno) << ")\n";
+        return 1;
+    }
+
+    string reply;
+    if (align) {
+        vector<string> reads = loadReads(readsFile);
+        cout << "Number of reads (M): " << reads.size() << " reads\n";
+        ofstream fout(outFile, ios::binary);
+        if (!request(fd, SERVE_HEADER, 0, 0, "", reply)) {
+            cerr << "헤더 요청 실패: " << reply << "\n";
+            return 1;
+        }
+        fout << reply;
+
+        // 묶음마다 [uint32 길이][서열]로 read를 이어 붙여 보내고, 결과를 받은 순서대로 기록
+        vector<double> latencies;
+        string payload;
+        auto t1 = steady_clock::now();
+        for (size_t first = 0; first < reads.size(); first += batch) {
+            size_t end = min(reads.size(), first + batch);
+            payload.clear();
+            for (size_t i = first; i < end; ++i) {
+                uint32_t len = reads[i].size();
+                payload.append(reinterpret_cast<const char*>(&len), sizeof(len));
+                payload += reads[i];
+            }
+            auto r1 = steady_clock::now();
+            if (!request(fd, SERVE_ALIGN, first, end - first, payload, reply)) {
+                cerr << "정렬 요청 실패: " << reply << "\n";
+                return 1;
+            }
+            latencies.push_back(duration_cast<duration<double, milli>>(steady_clock::now() - r1).count());
+            fout << reply;
+        }
+        double sec = duration_cast<duration<double>>(steady_clock::now() - t1).count();
+
+        cout << "정렬 요청 " << latencies.size() << "개 (묶음당 read " << batch << "개)";
+        if (!latencies.empty()) {
+            sort(latencies.begin(), latencies.end());
+            auto at = [&](double q) { return latencies[min(latencies.size() - 1, size_t(q * latencies.size()))]; };
+            cout << ", 왕복 지연 p50 " << at(0.5) << " ms, p99 " << at(0.99) << " ms";
+        }
+        cout << "\n정렬 처리량: " << (sec > 0 ? reads.size() / sec : 0) << " reads/s\n";
+    }
+    if (stats) {
+        if (!request(fd, SERVE_STATS, 0, 0, "", reply)) {
+            cerr << "통계 요청 실패: " << reply << "\n";
+            return 1;
+        }
+        cout << "서버: " << reply << "\n";
+    }
+    if (shutdownServer && !request(fd, SERVE_SHUTDOWN, 0, 0, "", reply)) {
+        cerr << "종료 요청 실패: " << reply << "\n";
+        return 1;
+    }
+    ::close(fd);
+    return 0;
+}
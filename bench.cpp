@@ -0,0 +1,439 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <random>
+#include <chrono>
+#include <ctime>
+#include <algorithm>
+#include <thread>
+#include <cstdio>
+#include <cstdlib>
+#include <sys/stat.h>
+#include <sys/wait.h>
+
+using namespace std;
+
+// 합성 reference/read를 만들어 aligner 엔진들과 brute_force(정답 기준)를 같은 조건으로 실행하고
+// 처리량, 단계별 시간, 최대 메모리, 정확도를 표/JSON/CSV로 출력하는 벤치마크
+
+// SA.cpp, brute_force.cpp와 같은 값
+const int MAX_ERROR = 10;
+
+// 비교할 aligner 설정 (이름, 추가 옵션)
+struct Engine {
+    const char* name;
+    const char* flags;
+};
+const Engine ENGINES[] = {
+    {"sa", ""},
+    {"kmer", "--kmer=12"},
+    {"lcp", "--lcp-search"},
+    {"fm", "--backend=fm"},
+    {"multi-seed", "--multi-seed"},
+    {"spaced", "--spaced-seeds=all"},
+    {"edit", "--multi-seed --edit-distance"},
+    {"stream", "--stream"},
+};
+
+struct BenchOptions {
+    size_t refLen = 1000000;    // N
+    size_t readCount = 1000;    // M
+    int readLen = 50;
+    double subRate = 0.01;      // 염기당 치환 확률
+    double indelRate = 0.0;     // 염기당 삽입/삭제 확률 (반반)
+    double revRate = 0.5;       // 역상보 가닥에서 뽑을 확률
+    uint64_t seed = 1;
+    int threads = max(1u, thread::hardware_concurrency());
+    bool forwardOnly = false;
+    string engines = "sa,fm,multi-seed,edit";
+    string extra;               // 모든 엔진에 덧붙일 aligner 옵션
+    string aligner = "./aligner", oracle = "./brute_force";
+    string dir = "bench_data", json = "bench.json", csv = "bench.csv";
+};
+
+// read마다 생성 시 기록한 정답 (forward 좌표 기준 시작 위치)
+struct Truth {
+    size_t origin;
+    bool reverse;
+    int subs, indels;
+};
+
+// 결과 파일 한 줄 (no match면 pos = -1)
+struct Call {
+    long long pos = -1;
+    int mismatch = 0;
+    bool reverse = false;
+    string cigar;
+};
+
+struct EngineResult {
+    string name, flags;
+    bool ok = false;
+    vector<pair<string, double>> stages;  // 로그의 "라벨: X초" 줄들 (순서 유지)
+    double readsPerSec = 0, rssMB = 0;
+    size_t mapped = 0, valid = 0, optimal = 0, correct = 0, extra = 0, atOrigin = 0;
+    double sensitivity = 0, precision = 0;
+};
+
+char complement(char c) {
+    switch (c) {
+        case 'A': return 'T';
+        case 'C': return 'G';
+        case 'G': return 'C';
+        default: return 'A';
+    }
+}
+
+string reverseComplement(const string& s) {
+    string rc(s.rbegin(), s.rend());
+    for (char& c : rc) c = complement(c);
+    return rc;
+}
+
+// 균일 랜덤 reference와, 치환/indel을 넣은 고정 길이 read 생성 (같은 seed면 같은 데이터)
+void generate(const BenchOptions& opt, string& ref, vector<string>& reads, vector<Truth>& truth) {
+    mt19937_64 rng(opt.seed);
+    uniform_real_distribution<double> unit(0, 1);
+    const char* bases = "ACGT";
+    ref.resize(opt.refLen);
+    for (char& c : ref) c = bases[rng() & 3];
+
+    // indel이 있어도 read 길이를 채울 수 있게 reference 끝에 여유를 둠
+    size_t slack = opt.readLen + 1;
+    uniform_int_distribution<size_t> start(0, opt.refLen - opt.readLen - slack);
+    reads.resize(opt.readCount);
+    truth.resize(opt.readCount);
+    for (size_t i = 0; i < opt.readCount; ++i) {
+        Truth& t = truth[i];
+        t = {start(rng), !opt.forwardOnly && unit(rng) < opt.revRate, 0, 0};
+        string& read = reads[i];
+        read.clear();
+        for (size_t p = t.origin; (int)read.size() < opt.readLen;) {
+            if (unit(rng) < opt.indelRate && !read.empty()) {
+                ++t.indels;
+                if (rng() & 1) read += bases[rng() & 3];  // 삽입
+                else ++p;                                 // 삭제
+                continue;
+            }
+            char c = ref[p++];
+            if (unit(rng) < opt.subRate) {
+                c = bases[(string("ACGT").find(c) + 1 + rng() % 3) & 3];
+                ++t.subs;
+            }
+            read += c;
+        }
+        if (t.reverse) read = reverseComplement(read);
+    }
+}
+
+bool writeData(const BenchOptions& opt, const string& ref, const vector<string>& reads, const vector<Truth>& truth) {
+    ofstream fref(opt.dir + "/reference.txt"), freads(opt.dir + "/reads.txt"), ftruth(opt.dir + "/truth.txt");
+    if (!fref || !freads || !ftruth) return false;
+    fref << ref << "\n";
+    for (const string& r : reads) freads << r << "\n";
+    for (size_t i = 0; i < truth.size(); ++i)
+        ftruth << i << "\t" << truth[i].origin << "\t" << (truth[i].reverse ? '-' : '+') << "\t" << truth[i].subs << "\t"
+               << truth[i].indels << "\n";
+    return true;
+}
+
+// "read index: i -> pos: P, mismatch: X, strand: S[, cigar: C]" 또는 "... -> no match"
+vector<Call> loadCalls(const string& file, size_t count) {
+    vector<Call> calls(count);
+    ifstream fin(file);
+    string line;
+    while (getline(fin, line)) {
+        size_t i;
+        if (sscanf(line.c_str(), "read index: %zu", &i) != 1 || i >= count) continue;
+        size_t p = line.find("pos: ");
+        if (p == string::npos) continue;
+        Call& c = calls[i];
+        c.pos = atoll(line.c_str() + p + 5);
+        size_t m = line.find("mismatch: ");
+        if (m != string::npos) c.mismatch = atoi(line.c_str() + m + 10);
+        c.reverse = line.find("strand: -") != string::npos;
+        size_t g = line.find("cigar: ");
+        if (g != string::npos) c.cigar = line.substr(g + 7);
+    }
+    return calls;
+}
+
+// 보고된 위치에서 거리를 다시 계산 (CIGAR가 있으면 M은 mismatch, I/D는 길이만큼 더함, 범위를 벗어나면 -1)
+int rescore(const string& ref, const string& read, const Call& c) {
+    string s = c.reverse ? reverseComplement(read) : read;
+    size_t r = c.pos, q = 0;
+    int dist = 0;
+    string cigar = c.cigar.empty() ? to_string(s.size()) + "M" : c.cigar;
+    for (size_t k = 0; k < cigar.size();) {
+        size_t n = 0;
+        while (k < cigar.size() && isdigit((unsigned char)cigar[k])) n = n * 10 + (cigar[k++] - '0');
+        if (k == cigar.size()) return -1;
+        char op = cigar[k++];
+        if (op == 'M') {
+            if (r + n > ref.size() || q + n > s.size()) return -1;
+            for (size_t j = 0; j < n; ++j) dist += ref[r + j] != s[q + j];
+            r += n, q += n;
+        } else if (op == 'I') {
+            q += n, dist += n;
+        } else if (op == 'D') {
+            r += n, dist += n;
+        } else {
+            return -1;
+        }
+    }
+    return q == s.size() ? dist : -1;
+}
+
+// 로그에서 "라벨: X초" 줄과 처리량, 최대 메모리 추출
+void parseLog(const string& file, EngineResult& er) {
+    ifstream fin(file);
+    string line;
+    while (getline(fin, line)) {
+        size_t colon = line.rfind(": ");
+        if (colon == string::npos) continue;
+        string label = line.substr(0, colon);
+        label.erase(0, label.find_first_not_of(' '));
+        const char* value = line.c_str() + colon + 2;
+        if (line.size() >= 3 && line.compare(line.size() - 3, 3, "초") == 0) er.stages.push_back({label, atof(value)});
+        else if (label == "정렬 처리량") er.readsPerSec = atof(value);
+        else if (label == "최대 메모리 사용량 (RSS)") er.rssMB = atof(value);
+    }
+}
+
+// 라벨이 prefix로 시작하는 첫 단계 시간 (없으면 0)
+double stageTime(const EngineResult& er, const string& prefix) {
+    for (const auto& s : er.stages)
+        if (s.first.rfind(prefix, 0) == 0) return s.second;
+    return 0;
+}
+
+// 정확도: oracle의 최소 Hamming 거리를 기준으로
+//  valid   = 보고한 위치에서 다시 계산한 거리가 보고한 값과 같음
+//  optimal = oracle이 매칭한 read 중 valid이고 거리가 oracle 이하 → sensitivity = optimal / oracle 매칭 수
+//  correct = valid이고 oracle보다 나쁘지 않음 (oracle이 못 찾은 indel read 포함) → precision = correct / 매칭 수
+void score(const string& ref, const vector<string>& reads, const vector<Truth>& truth, const vector<Call>& oracle,
+           const vector<Call>& calls, EngineResult& er) {
+    size_t oracleMapped = 0;
+    for (size_t i = 0; i < reads.size(); ++i) {
+        bool oracleHit = oracle[i].pos >= 0;
+        oracleMapped += oracleHit;
+        const Call& c = calls[i];
+        if (c.pos < 0) continue;
+        ++er.mapped;
+        bool valid = c.mismatch <= MAX_ERROR && rescore(ref, reads[i], c) == c.mismatch;
+        if (!valid) continue;
+        ++er.valid;
+        bool notWorse = !oracleHit || c.mismatch <= oracle[i].mismatch;
+        er.optimal += oracleHit && notWorse;
+        er.correct += notWorse;
+        er.extra += !oracleHit;
+        const Truth& t = truth[i];
+        er.atOrigin += c.reverse == t.reverse && llabs(c.pos - (long long)t.origin) <= t.indels;
+    }
+    er.sensitivity = oracleMapped ? double(er.optimal) / oracleMapped : 0;
+    er.precision = er.mapped ? double(er.correct) / er.mapped : 0;
+}
+
+string quote(const string& s) { return "'" + s + "'"; }
+
+int run(const string& cmd) {
+    int status = system(cmd.c_str());
+    return status == -1 ? -1 : WEXITSTATUS(status);
+}
+
+string gitCommit() {
+    string out;
+    if (FILE* p = popen("git rev-parse --short HEAD 2>/dev/null", "r")) {
+        char buf[64];
+        while (fgets(buf, sizeof(buf), p)) out += buf;
+        pclose(p);
+    }
+    while (!out.empty() && isspace((unsigned char)out.back())) out.pop_back();
+    return out.empty() ? "unknown" : out;
+}
+
+string jsonString(const string& s) {
+    string out = "\"";
+    for (char c : s) {
+        if (c == '"' || c == '\\') out += '\\';
+        out += c;
+    }
+    return out + "\"";
+}
+
+void writeJSON(const string& file, const BenchOptions& opt, const string& commit, const string& date, double oracleSec,
+               size_t oracleMapped, const vector<EngineResult>& results) {
+    ofstream out(file);
+    out << "{\n  \"commit\": " << jsonString(commit) << ",\n  \"date\": " << jsonString(date) << ",\n"
+        << "  \"params\": {\"N\": " << opt.refLen << ", \"M\": " << opt.readCount << ", \"read_len\": " << opt.readLen
+        << ", \"sub_rate\": " << opt.subRate << ", \"indel_rate\": " << opt.indelRate << ", \"rev_rate\": "
+        << (opt.forwardOnly ? 0 : opt.revRate) << ", \"seed\": " << opt.seed << ", \"threads\": " << opt.threads
+        << ", \"max_error\": " << MAX_ERROR << ", \"extra\": " << jsonString(opt.extra) << "},\n"
+        << "  \"oracle\": {\"seconds\": " << oracleSec << ", \"mapped\": " << oracleMapped << "},\n  \"engines\": [";
+    for (size_t e = 0; e < results.size(); ++e) {
+        const EngineResult& r = results[e];
+        out << (e ? "," : "") << "\n    {\"name\": " << jsonString(r.name) << ", \"flags\": " << jsonString(r.flags)
+            << ", \"ok\": " << (r.ok ? "true" : "false") << ", \"reads_per_sec\": " << r.readsPerSec
+            << ", \"peak_rss_mb\": " << r.rssMB << ",\n     \"stages\": {";
+        for (size_t s = 0; s < r.stages.size(); ++s)
+            out << (s ? ", " : "") << jsonString(r.stages[s].first) << ": " << r.stages[s].second;
+        out << "},\n     \"mapped\": " << r.mapped << ", \"valid\": " << r.valid << ", \"optimal\": " << r.optimal
+            << ", \"correct\": " << r.correct << ", \"extra\": " << r.extra << ", \"at_origin\": " << r.atOrigin
+            << ", \"sensitivity\": " << r.sensitivity << ", \"precision\": " << r.precision << "}";
+    }
+    out << "\n  ]\n}\n";
+}
+
+// 실행마다 엔진당 한 줄씩 덧붙임 (파일이 새로 생길 때만 헤더 기록) → 커밋 간 비교용
+void appendCSV(const string& file, const BenchOptions& opt, const string& commit, const string& date,
+               const vector<EngineResult>& results) {
+    struct stat st;
+    bool fresh = stat(file.c_str(), &st) != 0 || st.st_size == 0;
+    ofstream out(file, ios::app);
+    if (fresh)
+        out << "commit,date,engine,N,M,read_len,sub_rate,indel_rate,threads,ok,load_s,index_s,align_s,total_s,"
+               "reads_per_sec,peak_rss_mb,mapped,sensitivity,precision,at_origin\n";
+    for (const EngineResult& r : results)
+        out << commit << "," << date << "," << r.name << "," << opt.refLen << "," << opt.readCount << "," << opt.readLen
+            << "," << opt.subRate << "," << opt.indelRate << "," << opt.threads << "," << r.ok << ","
+            << stageTime(r, "[1]") << "," << stageTime(r, "[2]") << "," << stageTime(r, "[3]") << ","
+            << stageTime(r, "✅") << "," << r.readsPerSec << "," << r.rssMB << "," << r.mapped << "," << r.sensitivity
+            << "," << r.precision << "," << r.atOrigin << "\n";
+}
+
+void printUsage(const char* prog) {
+    cerr << "사용법: " << prog << " [옵션]\n"
+         << "  --n=N               reference 길이 (기본값: 1000000)\n"
+         << "  --m=M               read 수 (기본값: 1000)\n"
+         << "  --read-len=L        read 길이 (기본값: 50)\n"
+         << "  --sub-rate=P        염기당 치환 확률 (기본값: 0.01)\n"
+         << "  --indel-rate=P      염기당 삽입/삭제 확률 (기본값: 0)\n"
+         << "  --rev-rate=P        역상보 가닥 read 비율 (기본값: 0.5)\n"
+         << "  --seed=S            난수 seed (기본값: 1)\n"
+         << "  --threads=N         aligner, brute_force 스레드 수 (기본값: 하드웨어 스레드 수)\n"
+         << "  --forward-only      정방향 read만 만들고 양쪽 모두 정방향만 검색\n"
+         << "  --engines=LIST      쉼표로 구분한 엔진 이름 또는 all (기본값: sa,fm,multi-seed,edit)\n"
+         << "  --extra=\"OPTS\"      모든 엔진에 덧붙일 aligner 옵션 (예: --sa=parallel)\n"
+         << "  --aligner=PATH      aligner 실행 파일 (기본값: ./aligner)\n"
+         << "  --oracle=PATH       brute_force 실행 파일 (기본값: ./brute_force)\n"
+         << "  --dir=DIR           데이터/결과 디렉터리 (기본값: bench_data)\n"
+         << "  --json=FILE         JSON 결과 (기본값: bench.json)\n"
+         << "  --csv=FILE          CSV 결과, 실행마다 덧붙임 (기본값: bench.csv)\n"
+         << "엔진:";
+    for (const Engine& e : ENGINES) cerr << " " << e.name;
+    cerr << "\n";
+}
+
+int main(int argc, char* argv[]) {
+    BenchOptions opt;
+    for (int a = 1; a < argc; ++a) {
+        string arg = argv[a];
+        auto has = [&](const string& key) { return arg.rfind(key, 0) == 0; };
+        auto value = [&](const string& key) { return arg.substr(key.size()); };
+        if (has("--n=")) opt.refLen = stoull(value("--n="));
+        else if (has("--m=")) opt.readCount = stoull(value("--m="));
+        else if (has("--read-len=")) opt.readLen = stoi(value("--read-len="));
+        else if (has("--sub-rate=")) opt.subRate = stod(value("--sub-rate="));
+        else if (has("--indel-rate=")) opt.indelRate = stod(value("--indel-rate="));
+        else if (has("--rev-rate=")) opt.revRate = stod(value("--rev-rate="));
+        else if (has("--seed=")) opt.seed = stoull(value("--seed="));
+        else if (has("--threads=")) opt.threads = max(1, stoi(value("--threads=")));
+        else if (arg == "--forward-only") opt.forwardOnly = true;
+        else if (has("--engines=")) opt.engines = value("--engines=");
+        else if (has("--extra=")) opt.extra = value("--extra=");
+        else if (has("--aligner=")) opt.aligner = value("--aligner=");
+        else if (has("--oracle=")) opt.oracle = value("--oracle=");
+        else if (has("--dir=")) opt.dir = value("--dir=");
+        else if (has("--json=")) opt.json = value("--json=");
+        else if (has("--csv=")) opt.csv = value("--csv=");
+        else {
+            cerr << "알 수 없는 옵션: " << arg << "\n";
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+    if (opt.readLen < 1 || opt.refLen < 2 * (size_t)opt.readLen + 2) {
+        cerr << "--n은 read 길이의 2배보다 커야 함\n";
+        return 1;
+    }
+
+    vector<const Engine*> engines;
+    stringstream list(opt.engines);
+    for (string name; getline(list, name, ',');) {
+        bool found = false;
+        for (const Engine& e : ENGINES)
+            if (name == "all" || name == e.name) engines.push_back(&e), found = true;
+        if (!found) {
+            cerr << "알 수 없는 엔진: " << name << "\n";
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+
+    // 1. 데이터 생성
+    mkdir(opt.dir.c_str(), 0755);
+    string ref;
+    vector<string> reads;
+    vector<Truth> truth;
+    generate(opt, ref, reads, truth);
+    if (!writeData(opt, ref, reads, truth)) {
+        cerr << "데이터를 쓸 수 없음: " << opt.dir << "\n";
+        return 1;
+    }
+    cout << "[벤치마크] N=" << opt.refLen << " bp, M=" << opt.readCount << ", read 길이=" << opt.readLen
+         << ", 치환율=" << opt.subRate << ", indel율=" << opt.indelRate << ", 스레드=" << opt.threads << "\n";
+
+    string common = " --ref=" + quote(opt.dir + "/reference.txt") + " --reads=" + quote(opt.dir + "/reads.txt") +
+                    " --threads=" + to_string(opt.threads) + (opt.forwardOnly ? " --forward-only" : "");
+
+    // 2. 정답 기준 (brute_force)
+    string oracleOut = opt.dir + "/oracle.txt", oracleLog = opt.dir + "/oracle.log";
+    if (run(quote(opt.oracle) + common + " --out=" + quote(oracleOut) + " > " + quote(oracleLog) + " 2>&1") != 0) {
+        cerr << "brute_force 실행 실패 (" << oracleLog << " 참고)\n";
+        return 1;
+    }
+    EngineResult oracleRun;
+    parseLog(oracleLog, oracleRun);
+    double oracleSec = stageTime(oracleRun, "[2]");
+    vector<Call> oracle = loadCalls(oracleOut, reads.size());
+    size_t oracleMapped = count_if(oracle.begin(), oracle.end(), [](const Call& c) { return c.pos >= 0; });
+    cout << "brute_force: " << oracleSec << "초, 매칭 " << oracleMapped << " / " << reads.size() << "\n";
+
+    // 3. 엔진별 실행
+    vector<EngineResult> results;
+    for (const Engine* e : engines) {
+        EngineResult er;
+        er.name = e->name;
+        er.flags = string(e->flags) + (opt.extra.empty() || !*e->flags ? "" : " ") + opt.extra;
+        string out = opt.dir + "/" + er.name + ".txt", log = opt.dir + "/" + er.name + ".log";
+        er.ok = run(quote(opt.aligner) + common + " " + er.flags + " --out=" + quote(out) + " > " + quote(log) + " 2>&1") == 0;
+        if (er.ok) {
+            parseLog(log, er);
+            score(ref, reads, truth, oracle, loadCalls(out, reads.size()), er);
+        } else {
+            cerr << "aligner 실행 실패: " << er.name << " (" << log << " 참고)\n";
+        }
+        results.push_back(er);
+    }
+
+    cout << "엔진          reads/s    색인(초)  정렬(초)  RSS(MB)  매칭     sensitivity  precision  원위치\n";
+    for (const EngineResult& r : results) {
+        char line[256];
+        snprintf(line, sizeof(line), "%-12s %10.0f %9.3f %9.3f %8.1f %8zu %12.4f %10.4f %7zu\n", r.name.c_str(),
+                 r.readsPerSec, stageTime(r, "[2]"), stageTime(r, "[3]"), r.rssMB, r.mapped, r.sensitivity, r.precision,
+                 r.atOrigin);
+        cout << (r.ok ? line : r.name + " 실행 실패\n");
+    }
+
+    // 4. 기계 판독용 결과
+    string commit = gitCommit();
+    char date[32];
+    time_t now = time(nullptr);
+    strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S", localtime(&now));
+    writeJSON(opt.json, opt, commit, date, oracleSec, oracleMapped, results);
+    appendCSV(opt.csv, opt, commit, date, results);
+    cout << "결과: " << opt.json << ", " << opt.csv << " (commit " << commit << ")\n";
+    return all_of(results.begin(), results.end(), [](const EngineResult& r) { return r.ok; }) ? 0 : 1;
+}
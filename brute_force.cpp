@@ -4,41 +4,86 @@
 #include <vector>
 #include <chrono>
 #include <algorithm>
+#include <thread>
+#include <cstdlib>
 
 using namespace std;
 using namespace chrono;
 
-const int MAX_ERROR = 20;
+// SA.cpp와 같은 값이어야 두 결과를 바로 비교할 수 있음
+const int MAX_ERROR = 10;
+
+// reference의 한 레코드 (헤더 없는 단일 서열이면 이름이 빈 문자열)
+struct Contig {
+    string name;
+    size_t start, length;
+};
 
 // ✅ 파일 입출력
-string loadReference(const string& file) {
+// SA.cpp와 같은 좌표를 쓰도록 ACGT 외 문자도 'N'으로 자리를 유지하고, 레코드마다 contig로 기록
+string loadReference(const string& file, vector<Contig>& contigs) {
     ifstream fin(file);
     string line, seq;
     while (getline(fin, line)) {
-        if (line[0] == '>') continue;
+        if (!line.empty() && line[0] == '>') {
+            if (!contigs.empty() && seq.size() == contigs.back().start) contigs.pop_back();
+            size_t w = line.find_first_of(" \t\r");
+            contigs.push_back({line.substr(1, w == string::npos ? string::npos : w - 1), seq.size(), 0});
+            continue;
+        }
+        if (contigs.empty()) contigs.push_back({"", 0, 0});
         for (char c : line) {
+            if (isspace((unsigned char)c)) continue;
             char uc = toupper(c);
-            if (uc == 'A' || uc == 'T' || uc == 'G' || uc == 'C') seq += uc;
+            seq += (uc == 'A' || uc == 'T' || uc == 'G' || uc == 'C') ? uc : 'N';
         }
     }
+    for (size_t i = 0; i < contigs.size(); ++i)
+        contigs[i].length = (i + 1 < contigs.size() ? contigs[i + 1].start : seq.size()) - contigs[i].start;
+    if (!contigs.empty() && contigs.back().length == 0) contigs.pop_back();
     return seq;
 }
 
+// read 목록 로드 (1줄 1 read 또는 FASTQ)
 vector<string> loadReads(const string& file) {
     ifstream fin(file);
     vector<string> reads;
     string line;
+    bool fastq = false, first = true;
     while (getline(fin, line)) {
-        if (!line.empty()) reads.push_back(line);
+        if (line.empty()) continue;
+        if (first) fastq = line[0] == '@', first = false;
+        if (!fastq) {
+            reads.push_back(line);
+            continue;
+        }
+        if (line[0] != '@' || !getline(fin, line)) continue;
+        reads.push_back(line);
+        getline(fin, line); // '+'
+        getline(fin, line); // 품질
     }
     return reads;
 }
 
-// ✅ mismatch 계산 함수
-int countMismatch(const string& a, const string& b) {
+string reverseComplement(const string& s) {
+    string rc(s.rbegin(), s.rend());
+    for (char& c : rc) {
+        switch (c) {
+            case 'A': c = 'T'; break;
+            case 'C': c = 'G'; break;
+            case 'G': c = 'C'; break;
+            case 'T': c = 'A'; break;
+            default: c = 'N';
+        }
+    }
+    return rc;
+}
+
+// ✅ mismatch 계산 함수 (limit를 넘으면 더 세지 않고 limit + 1 반환)
+int countMismatch(const string& ref, size_t pos, const string& read, int limit) {
     int count = 0;
-    for (int i = 0; i < a.size(); ++i)
-        if (a[i] != b[i]) count++;
+    for (size_t i = 0; i < read.size(); ++i)
+        if (ref[pos + i] != read[i] && ++count > limit) break;
     return count;
 }
 
@@ -48,42 +93,90 @@ void printTime(const string& label, high_resolution_clock::time_point start, hig
     cout << label << " " << duration << "초\n";
 }
 
-// ✅ Brute-Force 정렬
-int main() {
+struct Hit {
+    size_t pos = 0;
+    int mismatch = MAX_ERROR + 1;
+    bool reverse = false;
+};
+
+// ✅ Brute-Force 정렬: contig 안에 있고 N과 겹치지 않는 모든 위치를 비교
+// nextN[j]: j 이후 첫 N 위치. 같은 mismatch면 앞 위치, 정방향을 유지 (SA.cpp와 같은 기준)
+void scan(const string& ref, const vector<Contig>& contigs, const vector<size_t>& nextN, const string& read, bool reverse,
+          Hit& best) {
+    for (const Contig& c : contigs) {
+        if (c.length < read.size()) continue;
+        size_t last = c.start + c.length - read.size();
+        for (size_t j = c.start; j <= last; ++j) {
+            if (nextN[j] < j + read.size()) {
+                j = nextN[j];
+                continue;
+            }
+            int mismatch = countMismatch(ref, j, read, best.mismatch - 1);
+            if (mismatch < best.mismatch) {
+                best = {j, mismatch, reverse};
+                if (mismatch == 0) return;  // perfect match found
+            }
+        }
+    }
+}
+
+void formatPos(ofstream& fout, const vector<Contig>& contigs, size_t pos) {
+    auto it = upper_bound(contigs.begin(), contigs.end(), pos, [](size_t p, const Contig& c) { return p < c.start; });
+    const Contig& c = *(it - 1);
+    if (c.name.empty()) fout << pos;
+    else fout << c.name << ":" << pos - c.start;
+}
+
+int main(int argc, char* argv[]) {
+    string refFile = "reference.txt", readsFile = "reads.txt", outFile = "result_brute.txt";
+    bool bothStrands = true;
+    int threads = max(1u, thread::hardware_concurrency());
+    for (int a = 1; a < argc; ++a) {
+        string arg = argv[a];
+        if (arg.rfind("--ref=", 0) == 0) refFile = arg.substr(6);
+        else if (arg.rfind("--reads=", 0) == 0) readsFile = arg.substr(8);
+        else if (arg.rfind("--out=", 0) == 0) outFile = arg.substr(6);
+        else if (arg.rfind("--threads=", 0) == 0) threads = max(1, atoi(arg.substr(10).c_str()));
+        else if (arg == "--forward-only") bothStrands = false;
+        else {
+            cerr << "알 수 없는 옵션: " << arg << "\n"
+                 << "사용법: " << argv[0] << " [--ref=FILE] [--reads=FILE] [--out=FILE] [--threads=N] [--forward-only]\n";
+            return 1;
+        }
+    }
+
     auto total_start = high_resolution_clock::now();
 
     // 1. 입력 로딩
     auto t1 = high_resolution_clock::now();
-    string reference = loadReference("reference.txt");
-    vector<string> reads = loadReads("reads.txt");
+    vector<Contig> contigs;
+    string reference = loadReference(refFile, contigs);
+    vector<string> reads = loadReads(readsFile);
+    vector<size_t> nextN(reference.size() + 1, reference.size());
+    for (size_t j = reference.size(); j-- > 0;) nextN[j] = reference[j] == 'N' ? j : nextN[j + 1];
     auto t2 = high_resolution_clock::now();
     printTime("[1] 입력 로딩:", t1, t2);
 
-    // 2. Brute-force 정렬
+    // 2. Brute-force 정렬 (read마다 독립이므로 스레드별로 나눠 계산한 뒤 순서대로 기록)
     t1 = high_resolution_clock::now();
-    ofstream fout("result_brute.txt");
+    vector<Hit> hits(reads.size());
 
-    for (int i = 0; i < reads.size(); ++i) {
-        const string& read = reads[i];
-        int bestMismatch = MAX_ERROR + 1;
-        int bestPos = -1;
-
-        for (int j = 0; j + read.size() <= reference.size(); ++j) {
-            string refSeg = reference.substr(j, read.size());
-            int mismatch = countMismatch(read, refSeg);
-
-            if (mismatch < bestMismatch) {
-                bestMismatch = mismatch;
-                bestPos = j;
-                if (mismatch == 0) break;  // perfect match found
-            }
-        }
+    #pragma omp parallel for schedule(dynamic, 16) num_threads(threads)
+    for (size_t i = 0; i < reads.size(); ++i) {
+        scan(reference, contigs, nextN, reads[i], false, hits[i]);
+        if (bothStrands && hits[i].mismatch > 0) scan(reference, contigs, nextN, reverseComplement(reads[i]), true, hits[i]);
+    }
 
+    ofstream fout(outFile);
+    for (size_t i = 0; i < reads.size(); ++i) {
         fout << "read index: " << i << " -> ";
-        if (bestMismatch <= MAX_ERROR)
-            fout << "pos: " << bestPos << ", mismatch: " << bestMismatch << "\n";
-        else
+        if (hits[i].mismatch <= MAX_ERROR) {
+            fout << "pos: ";
+            formatPos(fout, contigs, hits[i].pos);
+            fout << ", mismatch: " << hits[i].mismatch << ", strand: " << (hits[i].reverse ? '-' : '+') << "\n";
+        } else {
             fout << "no match\n";
+        }
     }
 
     fout.close();